@@ -0,0 +1,18 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <cstddef>
+
+// Heap allocation counter for debug builds. Building with -DALLOC_COUNTER (make DEBUG=1)
+// replaces the global operator new so every allocation is counted; otherwise nothing is
+// replaced and the count stays 0.
+#ifdef ALLOC_COUNTER
+const bool ALLOC_COUNTING = true;
+#else
+const bool ALLOC_COUNTING = false;
+#endif
+
+// Allocations made by the calling thread so far
+size_t allocationCount();
+
+#endif
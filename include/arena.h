@@ -0,0 +1,119 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Monotonic scratch memory for level generation. Allocating bumps a pointer and nothing is
+// freed on its own: an ArenaScope gives back everything allocated since it was opened, and
+// once an arena is empty again its blocks are merged into one. A workload that repeats (the
+// next candidate, the next round) then runs inside that block without touching the heap.
+class Arena {
+public:
+    explicit Arena(size_t firstBlockSize = 64 * 1024);
+    ~Arena();
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    // Release everything and merge the blocks
+    void reset();
+
+    size_t bytesUsed() const {
+        return used;
+    }
+    size_t peakBytes() const {  // Most bytes in use at once since the arena was created
+        return peak;
+    }
+    size_t capacity() const;
+    size_t blockAllocations() const {  // Heap blocks requested so far
+        return heapBlocks;
+    }
+
+private:
+    friend class ArenaScope;
+
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void addBlock(size_t minSize);
+    void releaseBlocks();
+
+    std::vector<Block> blocks;
+    size_t current;  // Block being filled
+    size_t offset;   // Bytes used in that block
+    size_t used;
+    size_t peak;
+    size_t nextBlockSize;
+    size_t heapBlocks;
+};
+
+// Everything allocated from the arena while the scope is open is released when it closes, so
+// functions that take a scratch arena can nest. Closing the outermost scope resets the arena.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena);
+    ~ArenaScope();
+
+private:
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    Arena& arena;
+    size_t block;
+    size_t offset;
+    size_t used;
+};
+
+// Scratch arena of the calling thread, for callers that do not keep one of their own
+Arena& threadScratchArena();
+
+// STL allocator drawing from an arena; without one it falls back to the heap, so containers
+// that only sometimes live in an arena keep a single type
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator(Arena* arena = nullptr) noexcept : arena(arena) {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {
+    }
+
+    T* allocate(size_t n) {
+        if (!arena)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena)
+            ::operator delete(p);
+    }
+
+    Arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
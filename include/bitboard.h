@@ -0,0 +1,131 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "tilegrid.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit (x must not be 0)
+inline int lowestBit(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Index of the highest set bit (x must not be 0)
+inline int highestBit(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+inline int popcount64(uint64_t x) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// One bit per map cell, each row stored as whole 64-bit words (bit x % 64 of word x / 64).
+// Set operations, shifts and dilations handle 64 cells per instruction. Padding bits past the
+// last column are always 0, and cells outside the map read as 0 after a shift.
+// A board built with an arena keeps its words there, and so do the boards derived from it.
+class Bitboard {
+public:
+    Bitboard();
+    Bitboard(int width, int height, Arena* arena = nullptr);
+
+    // Cells whose tile matches the predicate
+    static Bitboard fromTiles(const TileGrid& grid, bool (*predicate)(Tile),
+                              Arena* arena = nullptr);
+
+    Arena* arena() const {
+        return bits.get_allocator().arena;
+    }
+
+    int width() const {
+        return w;
+    }
+    int height() const {
+        return h;
+    }
+    int wordsPerRow() const {
+        return words;
+    }
+
+    bool test(int y, int x) const {
+        return (bits[y * words + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void set(int y, int x) {
+        bits[y * words + (x >> 6)] |= 1ULL << (x & 63);
+    }
+    void reset(int y, int x) {
+        bits[y * words + (x >> 6)] &= ~(1ULL << (x & 63));
+    }
+
+    const uint64_t* row(int y) const {
+        return &bits[y * words];
+    }
+    uint64_t* row(int y) {
+        return &bits[y * words];
+    }
+
+    // Inclusive rectangles, clamped to the map
+    void setRect(int y0, int x0, int y1, int x1);
+    bool rectClear(int y0, int x0, int y1, int x1) const;
+
+    void clear();
+    void clearRows(int y0, int y1);
+    bool any() const;
+    int count() const;
+
+    Bitboard& operator|=(const Bitboard& other);
+    Bitboard& operator&=(const Bitboard& other);
+    Bitboard& andNot(const Bitboard& other);  // this &= ~other
+
+    // Cell (y, x) of the result is cell (y - dy, x - dx) of this board, |dy|, |dx| <= 1
+    Bitboard shifted(int dy, int dx) const;
+
+    // Every cell within one step, diagonals included
+    Bitboard dilated() const;
+
+private:
+    void clearPadding();
+
+    int w, h, words;
+    ArenaVector<uint64_t> bits;
+};
+
+inline Bitboard operator&(Bitboard a, const Bitboard& b) {
+    return a &= b;
+}
+inline Bitboard operator|(Bitboard a, const Bitboard& b) {
+    return a |= b;
+}
+
+// One BFS layer, word-parallel: next = (frontier grown by one orthogonal step) & passable
+// & ~reached, then reached |= next. Returns false once nothing new was reached.
+// Only rows firstRow..lastRow of the frontier may have bits and `next` must be empty; on return
+// the two hold the rows of `next` that do, so a layer costs its own rows, not the whole map.
+bool expandFrontier(const Bitboard& frontier, const Bitboard& passable, Bitboard& reached,
+                    Bitboard& next, int& firstRow, int& lastRow);
+
+// Cells of `passable` reachable from (y, x) in at most maxSteps steps (-1 = unlimited)
+Bitboard floodFill(const Bitboard& passable, int y, int x, int maxSteps = -1);
+
+#endif
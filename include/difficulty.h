@@ -0,0 +1,138 @@
+#ifndef DIFFICULTY_H
+#define DIFFICULTY_H
+
+#include "mapgen.h"
+
+// Everything that differs between difficulty levels. The generator, the game, the menu and
+// the tools all read this table, so a new difficulty is one more entry. Profiles list every
+// DifficultyProfile field, one per line, in declaration order.
+struct DifficultySettings {
+    const char* name;         // Shown in the menu and the stats panel
+    const char* key;          // Lowercase, used in file names
+    const char* description;  // One line for the difficulty menu
+    int startStamina;         // Stamina of a new game, also the stamina cap
+    int roundReward;          // Stamina bonus for completing a round
+    DifficultyProfile profile;
+};
+
+constexpr DifficultySettings DIFFICULTIES[] = {
+    {"Easy", "easy", "A gentler start.", 200, 75,
+     {
+         15,                    // mapSize
+         3,                     // numPackages
+         6,                     // minPackageDistance
+         8,                     // minDestinationDistance
+         3,                     // numStripes
+         3,                     // minStripeLength
+         5,                     // maxStripeLength
+         3,                     // numClusters
+         2,                     // clusterSize
+         2,                     // maxBlocksPerRow
+         1,                     // numStations
+         2,                     // minPatches
+         3,                     // maxPatches
+         2,                     // minPatchRows
+         4,                     // maxPatchRows
+         2,                     // minPatchCols
+         4,                     // maxPatchCols
+         TerrainKind::CLASSIC,  // terrain
+         30,                    // obstacleDensity
+         8,                     // noiseScale
+         4,                     // caveIterations
+         8,                     // candidates
+         ScoreWeights{},        // weights
+     }},
+    {"Medium", "medium", "A standard challenge.", 270, 100,
+     {
+         20,                    // mapSize
+         4,                     // numPackages
+         7,                     // minPackageDistance
+         9,                     // minDestinationDistance
+         4,                     // numStripes
+         7,                     // minStripeLength
+         10,                    // maxStripeLength
+         3,                     // numClusters
+         3,                     // clusterSize
+         3,                     // maxBlocksPerRow
+         2,                     // numStations
+         3,                     // minPatches
+         4,                     // maxPatches
+         3,                     // minPatchRows
+         5,                     // maxPatchRows
+         3,                     // minPatchCols
+         5,                     // maxPatchCols
+         TerrainKind::CLASSIC,  // terrain
+         30,                    // obstacleDensity
+         8,                     // noiseScale
+         4,                     // caveIterations
+         8,                     // candidates
+         ScoreWeights{},        // weights
+     }},
+    {"Hard", "hard", "For the seasoned courier.", 350, 150,
+     {
+         25,                    // mapSize
+         5,                     // numPackages
+         8,                     // minPackageDistance
+         10,                    // minDestinationDistance
+         5,                     // numStripes
+         8,                     // minStripeLength
+         12,                    // maxStripeLength
+         3,                     // numClusters
+         4,                     // clusterSize
+         4,                     // maxBlocksPerRow
+         3,                     // numStations
+         4,                     // minPatches
+         5,                     // maxPatches
+         4,                     // minPatchRows
+         6,                     // maxPatchRows
+         4,                     // minPatchCols
+         6,                     // maxPatchCols
+         TerrainKind::CLASSIC,  // terrain
+         30,                    // obstacleDensity
+         8,                     // noiseScale
+         4,                     // caveIterations
+         8,                     // candidates
+         ScoreWeights{},        // weights
+     }},
+};
+
+constexpr int NUM_DIFFICULTIES = sizeof(DIFFICULTIES) / sizeof(DIFFICULTIES[0]);
+
+// Settings for difficulty index (0=Easy, 1=Medium, 2=Hard), falls back to Easy
+const DifficultySettings& difficultySettings(int difficulty);
+
+// Obstacles the classic terrain places, as listed in the menu
+constexpr int obstacleCount(const DifficultyProfile& profile) {
+    return profile.numStripes + profile.numClusters;
+}
+
+// A stripe, cluster or patch side of `length` cells can start somewhere in the interior: the
+// generator draws its start from randBelow(mapSize - length - 2), which needs a positive bound
+constexpr bool fitsInterior(int minLength, int maxLength, int mapSize) {
+    return minLength >= 1 && minLength <= maxLength && maxLength < mapSize - 2;
+}
+
+// Table entries are checked when the game is compiled rather than when a level is generated.
+// Every package and destination must fit the interior of a map without obstacles, which is
+// where generatePlayableLevel() places them as a last resort.
+constexpr bool difficultiesAreValid() {
+    for (const DifficultySettings& settings : DIFFICULTIES) {
+        const DifficultyProfile& profile = settings.profile;
+        const int size = profile.mapSize;
+        if (size < 8 || profile.numPackages < 1 || profile.numPackages > MAX_PACKAGES ||
+            2 * profile.numPackages > (size - 2) * (size - 2) - 2 ||
+            !fitsInterior(profile.minStripeLength, profile.maxStripeLength, size) ||
+            !fitsInterior(profile.clusterSize, profile.clusterSize, size) ||
+            profile.maxBlocksPerRow < 1 ||
+            !fitsInterior(profile.minPatchRows, profile.maxPatchRows, size) ||
+            !fitsInterior(profile.minPatchCols, profile.maxPatchCols, size) ||
+            profile.minPatches < 0 || profile.minPatches > profile.maxPatches ||
+            settings.startStamina <= 0 || settings.roundReward < 0)
+            return false;
+    }
+    return true;
+}
+static_assert(NUM_DIFFICULTIES > 0, "At least one difficulty is needed");
+static_assert(difficultiesAreValid(), "A difficulty table entry is out of range");
+
+#endif
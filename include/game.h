@@ -16,7 +16,7 @@ enum class GameState {
 
 class Game {
 public:
-    Game();
+    explicit Game(bool dailyChallenge = false);
     ~Game();
     void run();
 
@@ -28,9 +28,9 @@ private:
 
     // Added Members
     GameState current_state; // Current state of the game
-    int difficultyHighlight; // Currently selected difficulty option index
-    std::vector<std::string> difficultyItems; // Difficulty level names
+    int difficultyHighlight; // Currently selected difficulty option index (see difficulty.h)
     bool isNewGame; // For gamesaving
+    bool dailyChallenge; // Session seed comes from the date instead of random_device
 
     // Display Functions
     void displayMenu();
@@ -0,0 +1,66 @@
+#ifndef GAMECLOCK_H
+#define GAMECLOCK_H
+
+#include <chrono>
+
+// Round time as the game sees it. Play runs on the real steady clock; simulations and replays
+// use a virtual clock that only moves when advance() is called, so time scores come out the
+// same on every run and rounds take no wall time at all. Time spent paused never counts.
+class GameClock {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    enum class Source { REAL_TIME, VIRTUAL };
+
+    explicit GameClock(Source source = Source::REAL_TIME);
+
+    // Round time back to zero; a pause in progress stays in effect
+    void restart();
+
+    // Pauses nest: the clock runs again once every pause() has had its resume()
+    void pause();
+    void resume();
+
+    // Move a virtual clock forward, ignored in real time
+    void advance(Duration step);
+
+    Duration elapsed() const;
+    long long elapsedSeconds() const;
+
+    // Milliseconds until elapsedSeconds() changes by itself, -1 if it cannot (a virtual or
+    // paused clock), so a loop can sleep exactly until the display needs a new second
+    int msUntilNextSecond() const;
+
+    bool isVirtual() const {
+        return source == Source::VIRTUAL;
+    }
+
+private:
+    Duration now() const;
+
+    Source source;
+    std::chrono::steady_clock::time_point origin;  // Real time zero
+    Duration virtualNow;
+    Duration roundStart;
+    Duration pausedAt;  // Time the outermost pause began
+    int pauseDepth;
+};
+
+// Pauses the clock for as long as it lives, for dialogs that wait on the player
+class ClockPause {
+public:
+    explicit ClockPause(GameClock& clock) : clock(clock) {
+        clock.pause();
+    }
+    ~ClockPause() {
+        clock.resume();
+    }
+
+private:
+    ClockPause(const ClockPause&) = delete;
+    ClockPause& operator=(const ClockPause&) = delete;
+
+    GameClock& clock;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef GAMECORE_H
+#define GAMECORE_H
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "history.h"
+#include "mapgen.h"
+#include "rng.h"
+#include "tilegrid.h"
+
+// Everything play changes. Gameplay decides what happens and records it as events; only
+// applyEvent() (and startRound() for a new level) writes the state, so the state is always
+// the fold of the event stream and every consumer of that stream sees the same changes.
+struct CourierState {
+    // Current round
+    TileGrid grid;  // Also the entity index: idAt() names the package or station on a cell
+    std::vector<std::pair<int, int>> supplyStationLocations;  // Left end of station i, by id
+    int numPackages = 0;
+    int playerY = 0, playerX = 0;
+    int exitY = 0, exitX = 0;
+    int packagesDelivered = 0;
+    int stepsThisRound = 0;
+    uint64_t heldPackages = 0;     // Bit i is set while the player holds package i
+    int currentPackageIndex = -1;  // Selected package, -1 if none
+    bool doubleCostNextMove = false;
+
+    // Whole game
+    int roundNumber = 1;
+    int stamina = 0;
+    int maxStamina = 0;
+    int staminaAtRoundStart = 0;
+    long long totalScore = 0;
+    int lastRoundStepScore = 0;
+    int lastRoundTimeScore = 0;
+    bool gameOver = false;
+};
+
+// Apply one event to the state. Notices and refused actions change nothing.
+void applyEvent(CourierState& state, const HistoryRecord& event);
+
+// Take over a new level (its storage is moved out) and reset the round's counters
+void startRound(CourierState& state, Level& level);
+
+bool isHeld(const CourierState& state, int pkgIdx);
+int heldCount(const CourierState& state);
+
+// Held package after `from` (before it when going backwards), wrapping around; -1 if none
+int nextHeldPackage(const CourierState& state, int from, bool forward);
+
+struct WalkResult {
+    int steps;               // Tiles walked
+    HistoryEvent stoppedBy;  // BORDER, BLOCKED or TOO_TIRED if that ended the walk early,
+                             // COUNT otherwise
+};
+
+// Walk up to `steps` tiles towards (dy, dx), ending in exactly the state that many single
+// moves would. Each run of plain steps is one MOVED (or MOVED_STEPS) event; a supply station
+// or speed bump ends the run and gets its own event, and the border, an obstacle or too little
+// stamina end the walk with the event a single move would record there. A step that uses up
+// the last stamina ends the walk too, as it ends the game.
+// The state is only read: emit() must apply each event to it (applyEvent()) before returning.
+// Station rewards are drawn from rewardRng.
+WalkResult walkPlayer(const CourierState& state, int dy, int dx, int steps, Rng& rewardRng,
+                      const std::function<void(const HistoryRecord&)>& emit);
+
+struct RoundScore {
+    int stepScore;
+    int timeScore;
+    int total;
+};
+
+// Score of a finished round. Only whole seconds count, so a round replayed on a virtual
+// clock scores exactly the same.
+RoundScore scoreRound(int steps, long long seconds);
+
+// How often each event happened this session, kept up to date from the same stream
+class EventTally {
+public:
+    EventTally();
+    void record(const HistoryRecord& event);
+    int count(HistoryEvent event) const;
+    int steps() const {  // Tiles walked, counting every step of a batched move
+        return stepCount;
+    }
+
+private:
+    int counts[static_cast<int>(HistoryEvent::COUNT)];
+    int stepCount;
+};
+
+#endif
@@ -4,17 +4,28 @@
 #include <ncurses.h>
 #include <string>
 #include <vector>
-#include <chrono>
 #include <utility>
 #include <cmath>
+#include <cstdint>
 #include "game.h"
+#include "gameclock.h"
+#include "gamecore.h"
+#include "history.h"
+#include "layout.h"
+#include "levelpool.h"
+#include "prefetch.h"
+#include "rng.h"
+#include "tilegrid.h"
 
 class Gameplay {
 public:
-    Gameplay(const int &difficultyHighlight, GameState &current_state, bool isNewGame);
+    Gameplay(const int &difficultyHighlight, GameState &current_state, bool isNewGame,
+             bool dailyChallenge = false);
     ~Gameplay();
     void run();
-    void addHistoryMessage(const std::string& message);
+    // The one way anything happens: apply the event to the state, then hand it to the
+    // history and the tally. History text is only formatted when it is displayed.
+    void emit(HistoryEvent event, int a = 0, int b = 0, int c = 0, int d = 0);
 
 private:
     // Member Variables
@@ -22,34 +33,54 @@ private:
     int difficultyHighlight;
     std::string diff_str;
     int map_size;
-    int num_obs;
-    int num_pkg;
     int height, width;
-    int roundNumber;
-    int currentStamina;
-    int maxStamina;
-    int staminaAtRoundStart;
-    int stepsTakenThisRound;
-    long long totalScore;
-    int lastRoundStepScore;
-    int lastRoundTimeScore;
-    std::vector<std::string> historyMessages; // To store messages
-    std::chrono::steady_clock::time_point startTime;
+    CourierState core;   // Player, cargo, map and score; only changed through emit()
+    EventTally tally;    // Per-event session totals for the stats panel
+    GameHistory history; // Bounded in memory, older records spill to a log file
+    int historyScroll;   // Records between the newest one and the last line shown, 0 follows
+    int64_t historyMatch; // Record found by the last search, -1 if none
+    bool historyNoMatch;  // The last search found nothing
+    char historyQuery[32];
+    GameClock roundClock; // Time of the current round, stopped while a dialog is open
+    uint64_t sessionSeed; // Round maps are generated from roundSeed(sessionSeed, round number)
+    LevelPrefetcher levelPrefetcher; // Generates the next round's map in the background
+    LevelPool levelPool; // Pregenerated maps, used instead of live generation when present
+    Rng rewardRng; // Supply station rewards, its own stream of the session seed
+    bool dailyChallenge;
 
-    // Package Tracking
-    std::vector<bool> hasPackage; // Tracks if player is holding package i
-    int currentPackageIndex;      // Index (0 to num_pkg-1) of selected package, -1 if none
-    int packagesDelivered;
+    int packageScroll;       // First slot shown in the package panel
+    int moveCount;           // Count typed before a move ("7d"), 0 if none
 
-    // Gameplay Map & Player
-    std::vector<std::string> mapGrid;
-    int playerY, playerX;
-    int exitY, exitX;
-    std::vector<std::pair<int, int>> packagePickUpLocs;
-    std::vector<std::pair<int, int>> packageDestLocs;
-    std::vector<std::pair<int, int>> supplyStationLocations; // <<< Add this line
-    std::vector<std::pair<int, int>> speedBumpLocations; // <<< This should already exist
-    bool doubleStaminaCostNextMove;
+    // Panels are only erased and drawn again when something they show has changed
+    enum Panel : unsigned {
+        MAP_PANEL = 1 << 0,
+        STATS_PANEL = 1 << 1,
+        TIME_PANEL = 1 << 2,
+        LEGEND_PANEL = 1 << 3,
+        STAMINA_PANEL = 1 << 4,
+        HISTORY_PANEL = 1 << 5,
+        PACKAGE_PANEL = 1 << 6,
+        ALL_PANELS = (1 << 7) - 1
+    };
+    static const int PANEL_COUNT = 7;
+    unsigned dirtyPanels;    // Panel bits to draw in the next frame
+    int panelsRepainted;     // Panels the last drawn frame repainted, shown on the time panel
+    long long shownSecond;   // Elapsed second on the time panel
+
+    // The composed map stays between frames, so a move only rewrites the cells it changed
+    std::vector<chtype> mapCells; // Glyph and attributes per screen cell, two per tile
+    bool mapStale;           // Compose and write the whole map on its next draw
+    int changedCells[8];     // Tiles (y * width + x) to rewrite besides the player's
+    int changedCellCount;    // Past the array the map is marked stale instead
+    int drawnPlayerY, drawnPlayerX;
+
+    // Panels are only laid out again when the terminal size or the package row changes
+    int layoutHeight, layoutWidth, layoutRowWidth;
+
+    // Frame allocation check (debug builds, see alloccount.h)
+    bool steadyFrame;        // Cleared by dialogs, new rounds and resizes, which may allocate
+    size_t frameAllocations; // Heap allocations of the last frame
+    int allocatingFrames;    // Steady frames that allocated anyway, should stay 0
 
     // Windows
     WINDOW *mapWin;
@@ -59,11 +90,18 @@ private:
     WINDOW *staminaWin;
     WINDOW *historyWin;
     WINDOW *packageWin;
+    WINDOW *legendPad;       // Legend text, composed once and copied into legendWin
 
     // Private Methods
     void updateDifficultyVariables();
+    void startNewGame();
     void initializeMap();
     void resizeWindows();
+    static unsigned panelsChangedBy(HistoryEvent event);
+    void markChangedCells(const HistoryRecord& record);
+    void redrawAllPanels();
+    int repaintPanels();
+    void composeMapRow(int y);
     void displayMap();
     void displayStats();
     void displayTime();
@@ -72,13 +110,18 @@ private:
     bool displayQuitOptions();
 
     void displayHistory();
+    void scrollHistory(int records);
+    void searchHistory();
     void displayPackages();
     void handleInput(int ch);
-    void displayPopupMessage(const std::string& title, const std::vector<std::string>& lines); // Declare popup function
+    void movePlayer(int dy, int dx, int steps);
 
-    // Helper functions
-    bool invalidPackageDistance(const int& y, const int& x, const int& i);
-    bool invalidDestinationDistance(const int& y, const int& x, const int& destinationsPlaced);
+    // Cargo
+    void selectPackage(int pkgIdx);
+    int promptPackageNumber();
+    bool promptText(const char* title, const char* label, char* text, int maxLength,
+                    bool digitsOnly);
+    void displayPopupMessage(const std::string& title, const std::vector<std::string>& lines); // Declare popup function
 
     // Gamesaving functions
     void saveGameState();
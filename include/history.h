@@ -0,0 +1,119 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Everything that happens in a game. The history is the game's event stream: state changes
+// are applied from these records by applyEvent() (gamecore.h), and the rest are notices and
+// refused actions. A record stores the event and up to four integers; the text is only
+// produced by formatHistoryRecord() when a line is drawn.
+enum class HistoryEvent : uint8_t {
+    GAME_STARTED,      // round
+    DAILY_CHALLENGE,
+    NO_SUCH_PACKAGE,
+    PACKAGE_SELECTED,  // package number
+    LEVEL_COMPLETE,    // stamina bonus, round score, step score, time score
+    NEXT_ROUND,        // round
+    EXIT_BLOCKED,      // delivered, packages
+    NOTHING_HELD,
+    NO_PACKAGE_HERE,
+    PACKAGE_DATA_MISSING,
+    PICKED_UP,         // package number
+    ALREADY_HELD,      // package number
+    DROP_AT_EXIT,
+    DROPPED,           // package number
+    DELIVERED,         // package number
+    DROP_OCCUPIED,
+    NOTHING_TO_DROP,
+    EXITING,
+    CONTINUING,
+    RESIZED,
+    MOVED,             // cost, stamina before, stamina after, cell (y * width + x)
+    MOVED_STEPS,       // steps, stamina before, stamina after, cell (y * width + x)
+    SUPPLY_OPENED,     // gain, stamina before, stamina after, station id
+    SPEED_BUMP,        // next move costs double
+    OUT_OF_STAMINA,    // final score
+    TOO_TIRED,         // cost, stamina
+    STUCK,             // final score
+    BLOCKED,
+    BORDER,
+    GAME_SAVED,
+    SAVE_FAILED,
+    GAME_LOADED,
+    CONTINUING_ROUND,  // round
+    NO_SAVE,
+    FRAME_ALLOCATED,   // allocations (debug builds)
+    COUNT
+};
+
+struct HistoryRecord {
+    HistoryEvent event;
+    int32_t values[4];
+};
+
+// Longest formatted line, terminator included; longer text is cut
+const int HISTORY_LINE_LENGTH = 96;
+
+// Write the text of a record to out (at most size bytes), returns its length
+int formatHistoryRecord(const HistoryRecord& record, char* out, size_t size);
+
+// The whole session's history in bounded memory. The newest RING_CAPACITY records stay in a
+// ring; a writer thread appends every record to a log file, and older records are read back
+// from there, so scrolling and searching reach the first move of the session.
+// Without a log file (it could not be created, or a write to it failed) only the ring is kept.
+class GameHistory {
+public:
+    static const int RING_CAPACITY = 1024;
+
+    // The log is created (truncated) at logPath and removed again by the destructor
+    explicit GameHistory(const std::string& logPath);
+    ~GameHistory();
+
+    // Append a record. Never allocates; only waits if the writer is a whole ring behind.
+    void add(const HistoryRecord& record);
+
+    // Records added so far
+    int64_t size() const;
+
+    // First record that can still be read: 0, or the oldest one in the ring without a log
+    int64_t oldest() const;
+
+    // Copy records first .. first + n - 1 (clamped to size()) into out, returns how many were
+    // copied; 0 if first is older than oldest()
+    int read(int64_t first, int n, HistoryRecord* out);
+
+    // Newest record before `before` whose text contains `text` (ignoring case), -1 if none
+    int64_t findBackward(const char* text, int64_t before);
+
+private:
+    GameHistory(const GameHistory&) = delete;
+    GameHistory& operator=(const GameHistory&) = delete;
+
+    void writerLoop();
+    int readLog(int64_t first, int n, HistoryRecord* out);
+
+    static const int WRITE_BATCH = 256;
+
+    std::string logPath;
+    std::FILE* logWriter;  // Writer thread only, nullptr (under the mutex) once it failed
+    std::FILE* logReader;  // Caller's thread only
+    std::vector<HistoryRecord> ring;
+    std::vector<HistoryRecord> batch;  // Records being written, writer thread only
+
+    mutable std::mutex mutex;  // Guards ring, count, written and stopping
+    std::condition_variable pending;    // Records to write, or stopping
+    std::condition_variable spaceFreed;  // The writer caught up a bit
+    int64_t count;
+    int64_t written;  // Records flushed to the log, all of them without one
+    bool stopping;
+    std::thread writer;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+// Blocking waits for the game loops, so an idle game sleeps in the kernel instead of
+// polling getch() on a timer.
+
+// Make terminal resizes (SIGWINCH) wake waitForInput(). Call once after initscr(): the
+// handler ncurses installed keeps running, so getch() still reports KEY_RESIZE.
+void installResizeWakeup();
+
+// Sleep until a key is waiting on stdin, the terminal was resized, or timeoutMs passed
+// (a negative timeout waits for ever). Returns false on timeout. Keys ncurses has already
+// read ahead are not seen here, so call it only after getch() returned ERR.
+bool waitForInput(int timeoutMs);
+
+#endif
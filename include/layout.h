@@ -0,0 +1,24 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+// Position and size of a panel in screen cells
+struct PanelRect {
+    int y, x, height, width;
+};
+
+// Where every gameplay panel goes on a height x width terminal. The side panels take a
+// quarter of the width each, narrowed (down to a minimum) when the map needs the room; the
+// map is centered between them and above the bottom bar, so no panel covers it. A map too
+// big for that space gets a clipped window instead.
+struct GameLayout {
+    PanelRect map;
+    PanelRect legend, history;  // Left column
+    PanelRect time, stats;      // Right column
+    PanelRect stamina, package; // Bottom bar
+};
+
+// packageRowWidth is the width the package slots would like, the panel scrolls when it
+// gets less
+GameLayout computeLayout(int height, int width, int mapSize, int packageRowWidth);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef LEVELPOOL_H
+#define LEVELPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapgen.h"
+
+// Pregenerated level pools: a header followed by fixed-size records, so level i lives at
+// sizeof(header) + i * recordSize and can be read straight out of a memory-mapped file.
+//
+// Record layout (native byte order, every field 16-bit unless noted):
+//   uint64 seed
+//   startY, startX, exitY, exitX, stationCount, padding
+//   numPackages pickups (y, x), numPackages destinations (y, x), numStations stations (y, x)
+//   mapSize * mapSize Tile bytes, zero padded to a multiple of 8
+// Speed bumps are not stored, they are the SPEED_BUMP cells of the grid. Neither is the grid's
+// id layer, it is rebuilt from the coordinate lists.
+
+const char LEVEL_POOL_MAGIC[8] = {'K', 'E', 'E', 'T', 'A', 'P', 'L', '1'};
+const uint32_t LEVEL_POOL_VERSION = 2;
+
+struct LevelPoolHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t difficulty;
+    uint32_t mapSize;
+    uint32_t numPackages;
+    uint32_t numStations;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t baseSeed;
+};
+
+// Default pool file of a difficulty, next to savegame.txt
+std::string levelPoolPath(int difficulty);
+
+// Header describing a pool of `count` levels for this profile
+LevelPoolHeader makeLevelPoolHeader(const DifficultyProfile& profile, int difficulty,
+                                    uint64_t count, uint64_t baseSeed);
+
+// Serialize a level into a record of header.recordSize bytes.
+// Returns false if the level does not fit the record (too many stations, wrong map size).
+bool encodeLevel(const Level& level, const LevelPoolHeader& header, unsigned char* record);
+
+// Read-only view of a pool file. The file is memory-mapped where possible, so opening a pool
+// costs nothing per level and picking a level only copies that one record.
+class LevelPool {
+public:
+    LevelPool();
+    ~LevelPool();
+
+    // Open a pool; fails (and stays closed) if the file is missing or was built for another
+    // profile, so callers can fall back to live generation
+    bool open(const std::string& path, const DifficultyProfile& profile);
+    void close();
+
+    bool isOpen() const;
+    uint64_t size() const;
+
+    bool levelAt(uint64_t index, Level& level) const;
+
+    // Seeds map onto the pool by index, so a given seed always picks the same level
+    bool levelForSeed(uint64_t seed, Level& level) const;
+
+private:
+    LevelPool(const LevelPool&) = delete;
+    LevelPool& operator=(const LevelPool&) = delete;
+
+    const unsigned char* data;
+    size_t length;
+    LevelPoolHeader header;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;  // No mmap, the file is read into memory instead
+#endif
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef LEVELSCORE_H
+#define LEVELSCORE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "mapgen.h"
+
+// Quality metrics of a level, measured along a greedy delivery tour:
+// start -> nearest pending pickup / held package's destination -> ... -> exit
+struct LevelMetrics {
+    int tourLength;        // Steps of the whole tour
+    int deliveryDistance;  // Shortest walk between any package and its own destination
+    int bottlenecks;       // Tour cells squeezed between obstacles/border on both sides
+    int bumpExposure;      // Speed bumps stepped on by the tour
+    int usefulStations;    // Supply stations within a few steps of the tour
+};
+
+// Temporaries come from the scratch arena (the calling thread's one if not given)
+LevelMetrics measureLevel(const Level& level);
+LevelMetrics measureLevel(const Level& level, Arena& scratch);
+double scoreLevel(const LevelMetrics& metrics, const ScoreWeights& weights);
+
+// Generate profile.candidates levels in parallel from seeds derived from `seed` and keep the
+// best scored one; the result only depends on the profile and the seed.
+// Worker t draws its temporaries from scratch[t]; the vector grows to the worker count, so a
+// caller that keeps it reuses the same arenas for every level.
+Level generateBestLevel(const DifficultyProfile& profile, uint64_t seed);
+Level generateBestLevel(const DifficultyProfile& profile, uint64_t seed,
+                        std::vector<Arena>& scratch);
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef MAPGEN_H
+#define MAPGEN_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "tilegrid.h"
+
+// Obstacle layout algorithm, see terrain.h
+enum class TerrainKind {
+    CLASSIC,  // Stripes and small clusters
+    NOISE,    // Thresholded coherent noise
+    CAVE      // Cellular-automata caves
+};
+
+// Weights of the level quality score (see levelscore.h), higher scores are better
+struct ScoreWeights {
+    double tourLength = -0.05;       // Per step of the greedy delivery tour
+    double deliveryDistance = 1.0;   // Per step between the closest package/destination pair
+    double bottlenecks = -0.5;       // Per single-cell corridor on the tour
+    double bumpExposure = 0.5;       // Per speed bump on the tour
+    double usefulStations = 3.0;     // Per supply station close to the tour
+};
+
+// Everything the generator needs to know about a difficulty level
+struct DifficultyProfile {
+    int mapSize;
+    int numPackages;
+
+    // Minimum walking distances (in steps, around obstacles) between packages /
+    // between a package and its destination
+    int minPackageDistance;
+    int minDestinationDistance;
+
+    // Obstacle stripes (classic terrain)
+    int numStripes;
+    int minStripeLength;
+    int maxStripeLength;
+
+    // Obstacle clusters (classic terrain)
+    int numClusters;
+    int clusterSize;
+    int maxBlocksPerRow;
+
+    // Supply stations [$]
+    int numStations;
+
+    // Speed bump patches [~]
+    int minPatches;
+    int maxPatches;
+    int minPatchRows;
+    int maxPatchRows;
+    int minPatchCols;
+    int maxPatchCols;
+
+    // Obstacle layout. Noise terrain walls off obstacleDensity % of the interior in features
+    // about noiseScale cells wide. Cave terrain starts from obstacleDensity % random walls
+    // (around 45 gives open caves) and smooths them caveIterations times.
+    TerrainKind terrain = TerrainKind::CLASSIC;
+    int obstacleDensity = 30;
+    int noiseScale = 8;
+    int caveIterations = 4;
+
+    // Best-of-N generation: candidates generated in parallel, the best scored one is kept.
+    // Every candidate is generated, however long it takes, so the winner never depends on
+    // the speed of the machine.
+    int candidates = 8;
+    ScoreWeights weights;
+};
+
+// A complete generated level, independent of any ncurses state
+struct Level {
+    uint64_t seed;
+    TileGrid grid;  // Package/destination ids are package indices, station ids station indices
+    std::vector<std::pair<int, int>> packagePickUpLocs;
+    std::vector<std::pair<int, int>> packageDestLocs;
+    std::vector<std::pair<int, int>> supplyStationLocations;  // Left '[' cell of each station
+    std::vector<std::pair<int, int>> speedBumpLocations;
+    int startY, startX;
+    int exitY, exitX;
+};
+
+// Every field equal, so equal profiles always generate the same level for a seed
+bool operator==(const ScoreWeights& a, const ScoreWeights& b);
+bool operator==(const DifficultyProfile& a, const DifficultyProfile& b);
+
+// Most packages a level can hold; gameplay keeps the carried packages in one 64-bit mask
+const int MAX_PACKAGES = 64;
+
+// Profile for difficulty index (0=Easy, 1=Medium, 2=Hard), falls back to Easy
+DifficultyProfile profileForDifficulty(int difficulty);
+
+// Derive the seed of a given round from the session seed
+uint64_t roundSeed(uint64_t sessionSeed, int roundNumber);
+
+// Session seed shared by every player on the same (UTC) day
+uint64_t dailySeed();
+
+// Number of seeds generatePlayableLevel() tries before relaxing the spacing rules
+const int MAX_GENERATION_ATTEMPTS = 16;
+
+// Generate a level; identical profile and seed always give an identical level.
+// An exit the obstacles wall off is carved open, and everything else is only placed where the
+// start can reach it. Returns false if the packages/destinations cannot be placed with the
+// profile's spacing; the level is then incomplete and must not be used.
+// The level's storage is reused, and every temporary comes from the scratch arena (the
+// calling thread's one if not given) and is released again before returning.
+bool generateLevel(const DifficultyProfile& profile, uint64_t seed, Level& level);
+bool generateLevel(const DifficultyProfile& profile, uint64_t seed, Level& level,
+                   Arena& scratch);
+
+// Number of pickups, destinations, stations and exits that cannot be reached from the start
+int countUnreachableTargets(const Level& level);
+bool isLevelSolvable(const Level& level);
+
+// Clear obstacles until every target is reachable from the start, returns whether the level
+// is solvable afterwards
+bool repairLevel(Level& level);
+
+// Generate a complete level that isLevelSolvable() accepts. Tries new seeds until one gives
+// such a level, then relaxes the spacing rules (a new seed per step), then falls back to the
+// classic terrain and finally to a map without obstacles. Every level is checked, repaired
+// levels included, so the result is solvable for any profile difficultiesAreValid() accepts.
+Level generatePlayableLevel(const DifficultyProfile& profile, uint64_t seed);
+Level generatePlayableLevel(const DifficultyProfile& profile, uint64_t seed, Arena& scratch);
+
+#endif
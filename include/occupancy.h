@@ -0,0 +1,52 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "tilegrid.h"
+
+// Occupancy index over a square map, used by the generator to test whole rectangles in
+// O(log^2 size) and horizontal spans in O(1) instead of scanning every cell of the footprint.
+//
+// A cell is occupied if it is not free ground, or is protected such as the start. The index
+// keeps a 2D Fenwick tree of occupied cells, so a mark and a rectangle count both cost
+// O(log^2 size) however placement interleaves them, and the length of the free run starting
+// at every cell, updated in place on each mark.
+// (Wall clearance checks use a Bitboard of cells next to a wall instead, see terrain.cpp.)
+class OccupancyIndex {
+public:
+    // Build from a grid: every non-floor cell is occupied. The tables live in the arena if
+    // one is given.
+    explicit OccupancyIndex(const TileGrid& grid, Arena* arena = nullptr);
+
+    void markOccupied(int y, int x);
+    void markSpanOccupied(int y, int x, int len);
+
+    bool isOccupied(int y, int x) const;
+
+    // Inclusive rectangle query, the rectangle must be inside the map
+    bool rectFree(int y0, int x0, int y1, int x1) const;
+
+    // Are cells (y, x) .. (y, x + len - 1) all free?
+    bool spanFree(int y, int x, int len) const;
+
+    // Number of consecutive free cells starting at (y, x) going right
+    int freeRun(int y, int x) const;
+
+private:
+    void updateRun(int y, int x);
+    void addOccupied(int y, int x);
+    int countBefore(int y, int x) const;
+    int rectSum(int y0, int x0, int y1, int x1) const;
+
+    int size;
+    ArenaVector<uint8_t> occupied;
+    ArenaVector<int> runRight;
+
+    // (size + 1) x (size + 1) Fenwick tree over occupied, 1-based
+    ArenaVector<int> occupiedTree;
+};
+
+#endif
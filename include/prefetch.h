@@ -0,0 +1,40 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "arena.h"
+#include "mapgen.h"
+
+// Generates the next round's level on a worker thread while the current round is played.
+// Levels only depend on (profile, seed), so a prefetched level is exactly the one that would
+// have been generated synchronously; a prefetch for a different seed or profile is simply
+// discarded.
+// Levels come from generateBestLevel(), i.e. the best of profile.candidates candidates.
+// The generation workers keep their scratch arenas here, so rounds after the first one
+// generate without going back to the heap for temporaries.
+class LevelPrefetcher {
+public:
+    LevelPrefetcher();
+    ~LevelPrefetcher();
+
+    // Start generating the level for this seed in the background (replaces any pending job)
+    void start(const DifficultyProfile& profile, uint64_t seed);
+
+    // The level for this profile and seed: the prefetched one if both match, otherwise
+    // generated right now
+    Level take(const DifficultyProfile& profile, uint64_t seed);
+
+    // Drop any pending job (waits for the worker, generation is short and bounded)
+    void cancel();
+
+private:
+    std::future<Level> pending;
+    DifficultyProfile pendingProfile;
+    uint64_t pendingSeed;
+    std::vector<Arena> scratch;  // Only touched by one job at a time
+};
+
+#endif
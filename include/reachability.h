@@ -0,0 +1,32 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+#include "tilegrid.h"
+
+// Walkable cells of the grid as a bitboard
+Bitboard walkableCells(const TileGrid& grid, Arena* arena = nullptr);
+
+// Every cell reachable from (startY, startX), found by word-parallel frontier expansion
+Bitboard floodFill(const TileGrid& grid, int startY, int startX);
+
+// Value of unreachable cells in a distance field
+const int UNREACHABLE = -1;
+
+// BFS walking distance from (startY, startX) to every cell, row-major, UNREACHABLE if walled off.
+// Each BFS layer is one frontier expansion over the bitboard of walkable cells; the overload
+// taking that bitboard lets callers build it once for many fields.
+std::vector<int> distanceField(const TileGrid& grid, int startY, int startX);
+std::vector<int> distanceField(const Bitboard& walkable, int startY, int startX);
+
+// Same, written to distance[0 .. width * height). The BFS boards live in walkable's arena.
+void distanceField(const Bitboard& walkable, int startY, int startX, int* distance);
+
+// Connect (targetY, targetX) to the start by clearing the fewest obstacles possible
+// (0-1 BFS where stepping onto a wall costs 1). Returns the number of obstacles removed.
+int carvePath(TileGrid& grid, int startY, int startX, int targetY, int targetX);
+
+#endif
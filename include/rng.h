@@ -0,0 +1,77 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Independent random streams derived from one seed. Draws from one stream never shift
+// another, so e.g. station rewards cannot change the layout of later rounds.
+enum class RngStream : uint64_t {
+    LAYOUT = 1,   // Level generation
+    REWARDS = 2,  // Supply station stamina rewards
+    RETRIES = 3   // Seeds of further generation attempts when a level cannot be placed
+};
+
+// Small fast PRNG (xoshiro256**, 32 bytes of state) seeded through splitmix64.
+// Owned by whoever draws from it - there is no global state, so threads never share one -
+// and its output is the same on every compiler, unlike std::mt19937 + std:: distributions.
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed, RngStream stream = RngStream::LAYOUT) {
+        uint64_t z = seed ^ (static_cast<uint64_t>(stream) * 0xD1B54A32D192ED03ULL);
+        for (uint64_t& word : state) {
+            word = splitmix64(z);
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t splitmix64(uint64_t& z) {
+        uint64_t r = (z += 0x9E3779B97F4A7C15ULL);
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+        return r ^ (r >> 31);
+    }
+
+    uint64_t state[4];
+};
+
+// Random integer in [0, n) for n < 2^31: the top 32 bits scaled by n, no division
+inline int randBelow(Rng& rng, int n) {
+    return static_cast<int>(((rng() >> 32) * static_cast<uint64_t>(n)) >> 32);
+}
+
+// Fisher-Yates shuffle on top of randBelow (std::shuffle is implementation defined)
+template <typename T, typename Alloc>
+void shuffleVector(std::vector<T, Alloc>& values, Rng& rng) {
+    for (int i = static_cast<int>(values.size()) - 1; i > 0; --i) {
+        std::swap(values[i], values[randBelow(rng, i + 1)]);
+    }
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "arena.h"
+#include "mapgen.h"
+#include "rng.h"
+
+// Places the obstacles (walls) of a level. The grid comes in with its border, exit and start set;
+// generators must keep the start, the exit and the cells right next to them free.
+// Working memory comes from the scratch arena and is given back before carve() returns.
+class TerrainGenerator {
+public:
+    virtual ~TerrainGenerator() {
+    }
+    virtual void carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+                       Arena& scratch) const = 0;
+};
+
+// Original stripes + small clusters
+class ClassicTerrain : public TerrainGenerator {
+public:
+    void carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+               Arena& scratch) const override;
+};
+
+// Coherent value noise (two octaves), thresholded so profile.obstacleDensity % of cells are walls
+class NoiseTerrain : public TerrainGenerator {
+public:
+    void carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+               Arena& scratch) const override;
+};
+
+// Cellular-automata caves (4-5 rule) on bit-packed rows, 64 cells per word operation
+class CaveTerrain : public TerrainGenerator {
+public:
+    void carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+               Arena& scratch) const override;
+};
+
+// Generators are stateless, one shared instance per kind
+const TerrainGenerator& terrainGenerator(TerrainKind kind);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef TILEGRID_H
+#define TILEGRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// What occupies a map cell. The glyphs are only used for drawing.
+enum class Tile : uint8_t {
+    FLOOR,          // .
+    WALL,           // #  obstacle
+    BORDER_H,       // -
+    BORDER_V,       // |
+    CORNER,         // +
+    EXIT,           // Q
+    PICKUP,         // O  package waiting to be picked up (id = package)
+    DESTINATION,    // X  (id = package)
+    STATION_LEFT,   // [  (id = station)
+    STATION_MID,    // $
+    STATION_RIGHT,  // ]
+    SPEED_BUMP      // ~
+};
+
+// Id of cells that do not belong to a package or station
+const uint16_t NO_ENTITY = 0xFFFF;
+
+inline char tileGlyph(Tile tile) {
+    static const char glyphs[] = ".#-|+QOX[$]~";
+    return glyphs[static_cast<int>(tile)];
+}
+
+// Can the player stand on this tile? Everything except obstacles and the map border.
+inline bool isWalkable(Tile tile) {
+    return tile != Tile::WALL && tile != Tile::BORDER_H && tile != Tile::BORDER_V &&
+           tile != Tile::CORNER;
+}
+
+inline bool isStationTile(Tile tile) {
+    return tile == Tile::STATION_LEFT || tile == Tile::STATION_MID || tile == Tile::STATION_RIGHT;
+}
+
+// A map as two contiguous row-major layers: the tiles, and the package/destination/station
+// id of each cell. One allocation per layer whatever the size, and rows are plain pointers.
+class TileGrid {
+public:
+    TileGrid() : w(0), h(0) {
+    }
+    TileGrid(int width, int height, Tile fill = Tile::FLOOR)
+        : w(width), h(height), tiles(width * height, fill), ids(width * height, NO_ENTITY) {
+    }
+
+    // Start over as a width x height grid of `fill`, reusing the storage when it is big enough
+    void reset(int width, int height, Tile fill = Tile::FLOOR) {
+        w = width;
+        h = height;
+        tiles.assign(width * height, fill);
+        ids.assign(width * height, NO_ENTITY);
+    }
+
+    int width() const {
+        return w;
+    }
+    int height() const {
+        return h;
+    }
+    int cellCount() const {
+        return w * h;
+    }
+    int index(int y, int x) const {
+        return y * w + x;
+    }
+
+    Tile at(int y, int x) const {
+        return tiles[y * w + x];
+    }
+    Tile at(int cell) const {
+        return tiles[cell];
+    }
+    uint16_t idAt(int y, int x) const {
+        return ids[y * w + x];
+    }
+
+    void set(int y, int x, Tile tile, uint16_t id = NO_ENTITY) {
+        tiles[y * w + x] = tile;
+        ids[y * w + x] = id;
+    }
+
+    // Cells (y, x) .. (y, x + len - 1)
+    void fillSpan(int y, int x, int len, Tile tile, uint16_t id = NO_ENTITY) {
+        std::fill(tiles.begin() + y * w + x, tiles.begin() + y * w + x + len, tile);
+        std::fill(ids.begin() + y * w + x, ids.begin() + y * w + x + len, id);
+    }
+
+    const Tile* row(int y) const {
+        return &tiles[y * w];
+    }
+    Tile* row(int y) {
+        return &tiles[y * w];
+    }
+    const uint16_t* idRow(int y) const {
+        return &ids[y * w];
+    }
+
+    bool operator==(const TileGrid& other) const {
+        return w == other.w && h == other.h && tiles == other.tiles && ids == other.ids;
+    }
+    bool operator!=(const TileGrid& other) const {
+        return !(*this == other);
+    }
+
+private:
+    int w, h;
+    std::vector<Tile> tiles;
+    std::vector<uint16_t> ids;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "../include/alloccount.h"
+
+#include <cstddef>
+
+#ifdef ALLOC_COUNTER
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Per thread, so the level prefetcher's allocations do not land on the frame being measured
+thread_local size_t allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+size_t allocationCount() {
+    return allocations;
+}
+
+#else
+
+size_t allocationCount() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "../include/arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+Arena::Arena(size_t firstBlockSize)
+    : current(0), offset(0), used(0), peak(0), nextBlockSize(firstBlockSize), heapBlocks(0) {
+}
+
+Arena::~Arena() {
+    releaseBlocks();
+}
+
+Arena::Arena(Arena&& other) noexcept
+    : blocks(std::move(other.blocks)),
+      current(other.current),
+      offset(other.offset),
+      used(other.used),
+      peak(other.peak),
+      nextBlockSize(other.nextBlockSize),
+      heapBlocks(other.heapBlocks) {
+    other.blocks.clear();
+    other.current = 0;
+    other.offset = 0;
+    other.used = 0;
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        releaseBlocks();
+        blocks = std::move(other.blocks);
+        current = other.current;
+        offset = other.offset;
+        used = other.used;
+        peak = other.peak;
+        nextBlockSize = other.nextBlockSize;
+        heapBlocks = other.heapBlocks;
+        other.blocks.clear();
+        other.current = 0;
+        other.offset = 0;
+        other.used = 0;
+    }
+    return *this;
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        if (current < blocks.size()) {
+            Block& block = blocks[current];
+            uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + offset;
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (offset + padding + bytes <= block.size) {
+                char* result = block.data + offset + padding;
+                offset += padding + bytes;
+                used += padding + bytes;
+                peak = std::max(peak, used);
+                return result;
+            }
+            // Blocks kept from before a rewind are reused before asking the heap
+            if (current + 1 < blocks.size() && blocks[current + 1].size >= bytes + alignment) {
+                used += block.size - offset;  // The rest of this block is skipped
+                current++;
+                offset = 0;
+                continue;
+            }
+            used += block.size - offset;
+        }
+        addBlock(bytes + alignment);
+        current = blocks.size() - 1;
+        offset = 0;
+    }
+}
+
+void Arena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = capacity();
+        releaseBlocks();
+        addBlock(total);
+    }
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+size_t Arena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+void Arena::addBlock(size_t minSize) {
+    size_t size = std::max(nextBlockSize, minSize);
+    blocks.push_back({static_cast<char*>(::operator new(size)), size});
+    heapBlocks++;
+    nextBlockSize = size * 2;
+}
+
+void Arena::releaseBlocks() {
+    for (const Block& block : blocks) {
+        ::operator delete(block.data);
+    }
+    blocks.clear();
+}
+
+ArenaScope::ArenaScope(Arena& arena)
+    : arena(arena), block(arena.current), offset(arena.offset), used(arena.used) {
+}
+
+ArenaScope::~ArenaScope() {
+    if (block == 0 && offset == 0) {
+        arena.reset();
+        return;
+    }
+    arena.current = block;
+    arena.offset = offset;
+    arena.used = used;
+}
+
+Arena& threadScratchArena() {
+    static thread_local Arena arena;
+    return arena;
+}
@@ -0,0 +1,228 @@
+#include "../include/bitboard.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+// Bits from .. to (inclusive) of one word
+uint64_t bitRange(int from, int to) {
+    uint64_t upTo = (to == 63) ? ~0ULL : (2ULL << to) - 1;
+    return upTo & ~((1ULL << from) - 1);
+}
+
+// Bit x of the result is bit x - 1 of the row (cells move one column east)
+inline uint64_t fromWest(const uint64_t* row, int k) {
+    return (row[k] << 1) | (k > 0 ? row[k - 1] >> 63 : 0);
+}
+
+// Bit x of the result is bit x + 1 of the row (cells move one column west)
+inline uint64_t fromEast(const uint64_t* row, int k, int words) {
+    return (row[k] >> 1) | (k + 1 < words ? row[k + 1] << 63 : 0);
+}
+
+}  // namespace
+
+Bitboard::Bitboard() : w(0), h(0), words(0) {
+}
+
+Bitboard::Bitboard(int width, int height, Arena* arena)
+    : w(width),
+      h(height),
+      words((width + 63) / 64),
+      bits(words * height, 0, ArenaAllocator<uint64_t>(arena)) {
+}
+
+Bitboard Bitboard::fromTiles(const TileGrid& grid, bool (*predicate)(Tile), Arena* arena) {
+    Bitboard board(grid.width(), grid.height(), arena);
+    for (int y = 0; y < board.h; ++y) {
+        const Tile* tiles = grid.row(y);
+        uint64_t* out = board.row(y);
+        for (int x = 0; x < board.w; ++x) {
+            out[x >> 6] |= static_cast<uint64_t>(predicate(tiles[x])) << (x & 63);
+        }
+    }
+    return board;
+}
+
+void Bitboard::setRect(int y0, int x0, int y1, int x1) {
+    y0 = std::max(0, y0);
+    x0 = std::max(0, x0);
+    y1 = std::min(h - 1, y1);
+    x1 = std::min(w - 1, x1);
+    for (int y = y0; y <= y1; ++y) {
+        uint64_t* r = row(y);
+        for (int k = x0 >> 6; k <= x1 >> 6; ++k) {
+            r[k] |= bitRange(std::max(x0, k * 64) - k * 64, std::min(x1, k * 64 + 63) - k * 64);
+        }
+    }
+}
+
+bool Bitboard::rectClear(int y0, int x0, int y1, int x1) const {
+    y0 = std::max(0, y0);
+    x0 = std::max(0, x0);
+    y1 = std::min(h - 1, y1);
+    x1 = std::min(w - 1, x1);
+    for (int y = y0; y <= y1; ++y) {
+        const uint64_t* r = row(y);
+        for (int k = x0 >> 6; k <= x1 >> 6; ++k) {
+            if (r[k] & bitRange(std::max(x0, k * 64) - k * 64, std::min(x1, k * 64 + 63) - k * 64))
+                return false;
+        }
+    }
+    return true;
+}
+
+void Bitboard::clear() {
+    std::fill(bits.begin(), bits.end(), 0);
+}
+
+void Bitboard::clearRows(int y0, int y1) {
+    std::fill(bits.begin() + y0 * words, bits.begin() + (y1 + 1) * words, 0);
+}
+
+bool Bitboard::any() const {
+    for (uint64_t word : bits) {
+        if (word)
+            return true;
+    }
+    return false;
+}
+
+int Bitboard::count() const {
+    int total = 0;
+    for (uint64_t word : bits) {
+        total += popcount64(word);
+    }
+    return total;
+}
+
+Bitboard& Bitboard::operator|=(const Bitboard& other) {
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] |= other.bits[i];
+    }
+    return *this;
+}
+
+Bitboard& Bitboard::operator&=(const Bitboard& other) {
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] &= other.bits[i];
+    }
+    return *this;
+}
+
+Bitboard& Bitboard::andNot(const Bitboard& other) {
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] &= ~other.bits[i];
+    }
+    return *this;
+}
+
+Bitboard Bitboard::shifted(int dy, int dx) const {
+    Bitboard result(w, h, arena());
+    for (int y = 0; y < h; ++y) {
+        int sourceY = y - dy;
+        if (sourceY < 0 || sourceY >= h)
+            continue;
+        const uint64_t* source = row(sourceY);
+        uint64_t* out = result.row(y);
+        for (int k = 0; k < words; ++k) {
+            out[k] = (dx > 0) ? fromWest(source, k) : (dx < 0) ? fromEast(source, k, words) : source[k];
+        }
+    }
+    result.clearPadding();
+    return result;
+}
+
+Bitboard Bitboard::dilated() const {
+    // Grow along the rows first, then take the row above and below
+    Bitboard horizontal(w, h, arena());
+    for (int y = 0; y < h; ++y) {
+        const uint64_t* source = row(y);
+        uint64_t* out = horizontal.row(y);
+        for (int k = 0; k < words; ++k) {
+            out[k] = source[k] | fromWest(source, k) | fromEast(source, k, words);
+        }
+    }
+    Bitboard result = horizontal;
+    for (int y = 0; y < h; ++y) {
+        uint64_t* out = result.row(y);
+        for (int k = 0; k < words; ++k) {
+            if (y > 0)
+                out[k] |= horizontal.row(y - 1)[k];
+            if (y + 1 < h)
+                out[k] |= horizontal.row(y + 1)[k];
+        }
+    }
+    result.clearPadding();
+    return result;
+}
+
+void Bitboard::clearPadding() {
+    if (w % 64 == 0)
+        return;
+    const uint64_t keep = (1ULL << (w % 64)) - 1;
+    for (int y = 0; y < h; ++y) {
+        bits[y * words + words - 1] &= keep;
+    }
+}
+
+bool expandFrontier(const Bitboard& frontier, const Bitboard& passable, Bitboard& reached,
+                    Bitboard& next, int& firstRow, int& lastRow) {
+    const int height = frontier.height();
+    const int words = frontier.wordsPerRow();
+    const int fromRow = std::max(0, firstRow - 1);
+    const int toRow = std::min(height - 1, lastRow + 1);
+    firstRow = height;
+    lastRow = -1;
+    for (int y = fromRow; y <= toRow; ++y) {
+        uint64_t grown = 0;
+        const uint64_t* current = frontier.row(y);
+        const uint64_t* open = passable.row(y);
+        uint64_t* seen = reached.row(y);
+        uint64_t* out = next.row(y);
+        for (int k = 0; k < words; ++k) {
+            uint64_t step = current[k] | fromWest(current, k) | fromEast(current, k, words);
+            if (y > 0)
+                step |= frontier.row(y - 1)[k];
+            if (y + 1 < height)
+                step |= frontier.row(y + 1)[k];
+            // Passable has no padding bits set, so nothing leaks past the last column
+            out[k] = step & open[k] & ~seen[k];
+            seen[k] |= out[k];
+            grown |= out[k];
+        }
+        if (grown) {
+            firstRow = std::min(firstRow, y);
+            lastRow = y;
+        }
+    }
+    return lastRow >= 0;
+}
+
+Bitboard floodFill(const Bitboard& passable, int y, int x, int maxSteps) {
+    Bitboard reached(passable.width(), passable.height(), passable.arena());
+    if (!passable.test(y, x))
+        return reached;
+
+    Bitboard frontier(passable.width(), passable.height(), passable.arena());
+    Bitboard next(passable.width(), passable.height(), passable.arena());
+    reached.set(y, x);
+    frontier.set(y, x);
+    int firstRow = y;
+    int lastRow = y;
+    for (int step = 0; step != maxSteps; ++step) {
+        int oldFirst = firstRow;
+        int oldLast = lastRow;
+        if (!expandFrontier(frontier, passable, reached, next, firstRow, lastRow))
+            break;
+        frontier.clearRows(oldFirst, oldLast);  // Becomes the next empty `next`
+        std::swap(frontier, next);
+    }
+    return reached;
+}
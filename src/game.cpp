@@ -9,7 +9,9 @@
 #include <string>
 #include <vector>
 
+#include "../include/difficulty.h"
 #include "../include/gameplay.h"
+#include "../include/input.h"
 
 // Include windows.h only on Windows platforms
 // Make sure that the window will be maximized on Windows
@@ -22,13 +24,13 @@ const int MIN_HEIGHT = 31;
 const int MIN_WIDTH = 115;
 
 // Constructor initializes ncurses and create main window
-Game::Game()
+Game::Game(bool dailyChallenge)
     : menuHighlight(0),
       menuItems{"New Game", "Load Game", "Exit"},
       current_state(GameState::MAIN_MENU),
       difficultyHighlight(0),
-      difficultyItems{"Easy", "Medium", "Hard"},
-      isNewGame(false) {
+      isNewGame(false),
+      dailyChallenge(dailyChallenge) {
 #ifdef _WIN32
     // Get the console window handle and maximize it
     HWND consoleWindow = GetConsoleWindow();
@@ -44,6 +46,7 @@ Game::Game()
     keypad(stdscr, TRUE);  // Enable special keys
     start_color();         // Enable color support
     set_escdelay(0);       // Remove ESC delay
+    installResizeWakeup();  // Resizes wake the blocking game loops
 
     // Initialize color pairs
     init_pair(1, COLOR_YELLOW, COLOR_BLACK);
@@ -279,8 +282,8 @@ void Game::displayDifficultyMenu() {
     int descX = std::max(menuX + 15, width * 6 / 10);
 
     // Difficulty Options
-    int startY = height / 2 - difficultyItems.size() / 2;
-    for (int i = 0; i < difficultyItems.size(); ++i) {
+    int startY = height / 2 - NUM_DIFFICULTIES / 2;
+    for (int i = 0; i < NUM_DIFFICULTIES; ++i) {
         std::string prefix = (i == difficultyHighlight) ? ">> " : "   ";  // Add prefix
         if (i == difficultyHighlight) {
             wattron(mainWindow, A_REVERSE | COLOR_PAIR(1));  // Use same highlight style
@@ -288,7 +291,7 @@ void Game::displayDifficultyMenu() {
             wattroff(mainWindow, A_REVERSE | COLOR_PAIR(1));  // Ensure no highlight otherwise
         }
         mvwprintw(mainWindow, startY + i, menuX, "%s%s", prefix.c_str(),
-                  difficultyItems[i].c_str());
+                  difficultySettings(i).name);
     }
     wattroff(mainWindow, A_REVERSE | COLOR_PAIR(1));  // Turn off highlight after loop
 
@@ -299,47 +302,17 @@ void Game::displayDifficultyMenu() {
     wattron(mainWindow, COLOR_PAIR(2));
     mvwprintw(mainWindow, rightY++, descX, "-------------------------");
 
-    std::string map_size, packages, obstacles, desc, stamina, reward;
-    switch (difficultyHighlight) {
-        // EZ
-        case 0:
-            map_size = "15x15";
-            packages = "3";
-            obstacles = "6";
-            stamina = "200";
-            reward = "75";
-            desc = "A gentler start.";
-            break;
-        // Medium
-        case 1:
-            map_size = "20x20";
-            packages = "4";
-            obstacles = "7";
-            stamina = "270";
-            reward = "100";
-            desc = "A standard challenge.";
-            break;
-        // Hard
-        case 2:
-            map_size = "25x25";
-            packages = "5";
-            obstacles = "8";
-            stamina = "350";
-            reward = "150";
-            desc = "For the seasoned courier.";
-            break;
-    }
-
-    mvwprintw(mainWindow, rightY++, descX, "Difficulty: %s",
-              difficultyItems[difficultyHighlight].c_str());
-    mvwprintw(mainWindow, rightY++, descX, "Description: %s", desc.c_str());
+    const DifficultySettings& settings = difficultySettings(difficultyHighlight);
+    const DifficultyProfile& profile = settings.profile;
+    mvwprintw(mainWindow, rightY++, descX, "Difficulty: %s", settings.name);
+    mvwprintw(mainWindow, rightY++, descX, "Description: %s", settings.description);
     mvwprintw(mainWindow, rightY++, descX, " ");
-    mvwprintw(mainWindow, rightY++, descX, "Map Size:    %s", map_size.c_str());
-    mvwprintw(mainWindow, rightY++, descX, "Packages:    %s", packages.c_str());
-    mvwprintw(mainWindow, rightY++, descX, "Obstacles:   %s", obstacles.c_str());
+    mvwprintw(mainWindow, rightY++, descX, "Map Size:    %dx%d", profile.mapSize, profile.mapSize);
+    mvwprintw(mainWindow, rightY++, descX, "Packages:    %d", profile.numPackages);
+    mvwprintw(mainWindow, rightY++, descX, "Obstacles:   %d", obstacleCount(profile));
     mvwprintw(mainWindow, rightY++, descX, " ");
-    mvwprintw(mainWindow, rightY++, descX, "Stamina: %s start, +%s/lvl", stamina.c_str(),
-              reward.c_str());
+    mvwprintw(mainWindow, rightY++, descX, "Stamina: %d start, +%d/lvl", settings.startStamina,
+              settings.roundReward);
     mvwprintw(mainWindow, rightY++, descX, "Score based on completion,");
     mvwprintw(mainWindow, rightY++, descX, "time, and packages.");
     mvwprintw(mainWindow, rightY++, descX, "-------------------------");
@@ -437,7 +410,7 @@ void Game::waitForResize() {
             }
         }
 
-        napms(100);
+        waitForInput(-1);  // Sleep until a key or a resize
     }
 
     nodelay(stdscr, FALSE);
@@ -468,7 +441,7 @@ void Game::waitForResize() {
 void Game::newGame(const int difficultyHighlight, bool isNewGame) {
     // TODO: Initialize game state based on difficulty (map size, packages, etc.)
     // TODO: Enter the actual game loop here (or elsewhere, I might be reconstructing it soon)
-    Gameplay gameplay(difficultyHighlight, current_state, isNewGame);
+    Gameplay gameplay(difficultyHighlight, current_state, isNewGame, dailyChallenge);
     gameplay.run();
 }
 
@@ -598,11 +571,10 @@ void Game::handleMainMenuInput(int choice) {
 void Game::handleDifficultyInput(int choice) {
     switch (choice) {
         case KEY_UP:
-            difficultyHighlight =
-                (difficultyHighlight - 1 + difficultyItems.size()) % difficultyItems.size();
+            difficultyHighlight = (difficultyHighlight - 1 + NUM_DIFFICULTIES) % NUM_DIFFICULTIES;
             break;
         case KEY_DOWN:
-            difficultyHighlight = (difficultyHighlight + 1) % difficultyItems.size();
+            difficultyHighlight = (difficultyHighlight + 1) % NUM_DIFFICULTIES;
             break;
         case '\n':
         case KEY_ENTER:
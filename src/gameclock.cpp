@@ -0,0 +1,56 @@
+#include "../include/gameclock.h"
+
+#include <chrono>
+
+GameClock::GameClock(Source source)
+    : source(source),
+      origin(std::chrono::steady_clock::now()),
+      virtualNow(Duration::zero()),
+      roundStart(Duration::zero()),
+      pausedAt(Duration::zero()),
+      pauseDepth(0) {}
+
+void GameClock::restart() {
+    roundStart = (pauseDepth > 0) ? pausedAt : now();
+}
+
+void GameClock::pause() {
+    if (pauseDepth++ == 0)
+        pausedAt = now();
+}
+
+void GameClock::resume() {
+    if (pauseDepth == 0)
+        return;
+    if (--pauseDepth == 0)
+        roundStart += now() - pausedAt;  // The paused stretch is skipped
+}
+
+void GameClock::advance(Duration step) {
+    if (isVirtual() && step > Duration::zero())
+        virtualNow += step;
+}
+
+GameClock::Duration GameClock::elapsed() const {
+    return ((pauseDepth > 0) ? pausedAt : now()) - roundStart;
+}
+
+long long GameClock::elapsedSeconds() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(elapsed()).count();
+}
+
+int GameClock::msUntilNextSecond() const {
+    if (isVirtual() || pauseDepth > 0)
+        return -1;
+    const Duration second = std::chrono::seconds(1);
+    Duration left = second - elapsed() % second;
+    // Rounded up, so the wait never ends just before the second turns
+    return static_cast<int>((left + std::chrono::milliseconds(1) - Duration(1)) /
+                            std::chrono::milliseconds(1));
+}
+
+GameClock::Duration GameClock::now() const {
+    if (isVirtual())
+        return virtualNow;
+    return std::chrono::steady_clock::now() - origin;
+}
@@ -0,0 +1,228 @@
+#include "../include/gamecore.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "../include/bitboard.h"
+#include "../include/history.h"
+#include "../include/mapgen.h"
+#include "../include/rng.h"
+#include "../include/tilegrid.h"
+
+void applyEvent(CourierState& state, const HistoryRecord& event) {
+    const int32_t* v = event.values;
+    switch (event.event) {
+        case HistoryEvent::MOVED:
+            state.stamina = v[2];
+            state.playerY = v[3] / state.grid.width();
+            state.playerX = v[3] % state.grid.width();
+            state.stepsThisRound++;
+            state.doubleCostNextMove = false;  // Spent by this move
+            break;
+        case HistoryEvent::MOVED_STEPS:
+            state.stamina = v[2];
+            state.playerY = v[3] / state.grid.width();
+            state.playerX = v[3] % state.grid.width();
+            state.stepsThisRound += v[0];
+            state.doubleCostNextMove = false;
+            break;
+        case HistoryEvent::BLOCKED:
+        case HistoryEvent::BORDER:
+            state.doubleCostNextMove = false;  // A bumped move still uses it up
+            break;
+        case HistoryEvent::SPEED_BUMP:
+            state.doubleCostNextMove = true;
+            break;
+        case HistoryEvent::SUPPLY_OPENED: {
+            state.stamina = v[2];
+            // Used stations leave the grid, so any station tile left is an active one
+            const std::pair<int, int>& station = state.supplyStationLocations[v[3]];
+            state.grid.fillSpan(station.first, station.second, 3, Tile::FLOOR);
+        } break;
+        case HistoryEvent::PACKAGE_SELECTED:
+            state.currentPackageIndex = v[0] - 1;
+            break;
+        case HistoryEvent::PICKED_UP:
+            state.heldPackages |= 1ULL << (v[0] - 1);
+            state.grid.set(state.playerY, state.playerX, Tile::FLOOR);
+            state.currentPackageIndex = v[0] - 1;
+            break;
+        case HistoryEvent::DROPPED:
+            state.heldPackages &= ~(1ULL << (v[0] - 1));
+            // The id keeps its color and lets it be picked up again
+            state.grid.set(state.playerY, state.playerX, Tile::PICKUP, v[0] - 1);
+            state.currentPackageIndex = nextHeldPackage(state, v[0] - 1, true);
+            break;
+        case HistoryEvent::DELIVERED:
+            state.heldPackages &= ~(1ULL << (v[0] - 1));
+            state.packagesDelivered++;
+            state.grid.set(state.playerY, state.playerX, Tile::FLOOR);
+            state.currentPackageIndex = nextHeldPackage(state, v[0] - 1, true);
+            break;
+        case HistoryEvent::LEVEL_COMPLETE:
+            state.stamina = std::min(state.maxStamina, state.stamina + v[0]);
+            state.staminaAtRoundStart = state.stamina;
+            state.totalScore += v[1];
+            state.lastRoundStepScore = v[2];
+            state.lastRoundTimeScore = v[3];
+            break;
+        case HistoryEvent::NEXT_ROUND:
+            state.roundNumber = v[0];
+            break;
+        case HistoryEvent::OUT_OF_STAMINA:
+        case HistoryEvent::STUCK:
+            state.gameOver = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void startRound(CourierState& state, Level& level) {
+    state.numPackages = static_cast<int>(level.packagePickUpLocs.size());
+    state.grid = std::move(level.grid);
+    state.supplyStationLocations = std::move(level.supplyStationLocations);
+    state.playerY = level.startY;
+    state.playerX = level.startX;
+    state.exitY = level.exitY;
+    state.exitX = level.exitX;
+    state.packagesDelivered = 0;
+    state.stepsThisRound = 0;
+    state.heldPackages = 0;
+    state.currentPackageIndex = -1;
+    state.doubleCostNextMove = false;
+}
+
+bool isHeld(const CourierState& state, int pkgIdx) {
+    return (state.heldPackages >> pkgIdx) & 1;
+}
+
+int heldCount(const CourierState& state) {
+    return popcount64(state.heldPackages);
+}
+
+// A couple of mask operations whatever the package count
+int nextHeldPackage(const CourierState& state, int from, bool forward) {
+    const uint64_t held = state.heldPackages;
+    if (held == 0)
+        return -1;
+    if (forward) {
+        uint64_t after = (from >= 63) ? 0 : held & (~0ULL << (from + 1));
+        return lowestBit(after ? after : held);
+    }
+    uint64_t before = (from <= 0) ? 0 : held & ((1ULL << from) - 1);
+    return highestBit(before ? before : held);
+}
+
+WalkResult walkPlayer(const CourierState& state, int dy, int dx, int steps, Rng& rewardRng,
+                      const std::function<void(const HistoryRecord&)>& emit) {
+    auto record = [&](HistoryEvent event, int a, int b, int c, int d) {
+        const HistoryRecord entry = {event, {a, b, c, d}};
+        emit(entry);
+    };
+
+    int y = state.playerY;
+    int x = state.playerX;
+    int stamina = state.stamina;
+    bool doubleCost = state.doubleCostNextMove;
+    int runSteps = 0;
+    int runStamina = stamina;  // Stamina before the run
+    WalkResult result = {0, HistoryEvent::COUNT};
+
+    auto endRun = [&]() {
+        int cell = state.grid.index(y, x);
+        if (runSteps == 1)
+            record(HistoryEvent::MOVED, runStamina - stamina, runStamina, stamina, cell);
+        else if (runSteps > 1)
+            record(HistoryEvent::MOVED_STEPS, runSteps, runStamina, stamina, cell);
+        runSteps = 0;
+        runStamina = stamina;
+    };
+
+    for (; result.steps < steps; ++result.steps) {
+        if (result.steps > 0 && stamina <= 0)
+            break;  // Out of stamina, the game is over
+
+        int nextY = y + dy;
+        int nextX = x + dx;
+        // Base cost = 1 + number of packages held, doubled after a speed bump
+        int moveCost = (1 + heldCount(state)) * (doubleCost ? 2 : 1);
+
+        // A bumped move still uses up a speed bump; a move too tired to start keeps it
+        HistoryEvent stop = HistoryEvent::COUNT;
+        if (nextY <= 0 || nextY >= state.grid.height() - 1 || nextX <= 0 ||
+            nextX >= state.grid.width() - 1)
+            stop = HistoryEvent::BORDER;
+        else if (state.grid.at(nextY, nextX) == Tile::WALL)
+            stop = HistoryEvent::BLOCKED;
+        else if (stamina < moveCost)
+            stop = HistoryEvent::TOO_TIRED;
+        if (stop != HistoryEvent::COUNT) {
+            endRun();
+            if (stop == HistoryEvent::TOO_TIRED)
+                record(stop, moveCost, stamina, 0, 0);
+            else
+                record(stop, 0, 0, 0, 0);
+            result.stoppedBy = stop;
+            return result;
+        }
+
+        // Take the step; moving uses up a pending speed bump
+        y = nextY;
+        x = nextX;
+        stamina -= moveCost;
+        doubleCost = false;
+        runSteps++;
+
+        // Used stations are cleared from the grid, so any station tile is active
+        if (isStationTile(state.grid.at(y, x))) {
+            endRun();
+            int stationId = state.grid.idAt(y, x);
+            int staminaGain = randBelow(rewardRng, 41) + 60;  // Ranging from 60-100
+            record(HistoryEvent::SUPPLY_OPENED, staminaGain, state.stamina,
+                   std::min(state.maxStamina, state.stamina + staminaGain), stationId);
+            stamina = runStamina = state.stamina;
+        }
+
+        if (state.grid.at(y, x) == Tile::SPEED_BUMP) {
+            endRun();
+            record(HistoryEvent::SPEED_BUMP, 0, 0, 0, 0);
+            doubleCost = true;
+        }
+    }
+    endRun();
+    return result;
+}
+
+RoundScore scoreRound(int steps, long long seconds) {
+    // Base scores and penalties
+    const int BASE_STEP_SCORE = 1000;
+    const int STEP_PENALTY = 5;
+    const int BASE_TIME_SCORE = 1000;
+    const int TIME_PENALTY = 2;
+
+    RoundScore score;
+    score.stepScore = std::max(0, BASE_STEP_SCORE - steps * STEP_PENALTY);
+    score.timeScore = static_cast<int>(std::max(0LL, BASE_TIME_SCORE - seconds * TIME_PENALTY));
+    score.total = score.stepScore + score.timeScore;
+    return score;
+}
+
+EventTally::EventTally() : stepCount(0) {
+    std::fill(counts, counts + static_cast<int>(HistoryEvent::COUNT), 0);
+}
+
+void EventTally::record(const HistoryRecord& event) {
+    if (event.event < HistoryEvent::COUNT)
+        counts[static_cast<int>(event.event)]++;
+    if (event.event == HistoryEvent::MOVED)
+        stepCount++;
+    else if (event.event == HistoryEvent::MOVED_STEPS)
+        stepCount += event.values[0];
+}
+
+int EventTally::count(HistoryEvent event) const {
+    return counts[static_cast<int>(event)];
+}
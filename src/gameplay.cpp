@@ -3,429 +3,227 @@
 #include <ncurses.h>
 
 #include <algorithm>
-#include <chrono>  // For timing
 #include <cmath>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
 #include <random>
 #include <set>
-#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../include/alloccount.h"
+#include "../include/bitboard.h"
+#include "../include/difficulty.h"
 #include "../include/game.h"
+#include "../include/gameclock.h"
+#include "../include/history.h"
+#include "../include/input.h"
+#include "../include/mapgen.h"
+#include "../include/prefetch.h"
+#include "../include/rng.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Package colors cycle through pairs 4-8; every other lap is drawn bold so neighbours differ
+const int PACKAGE_COLORS = 5;
+
+attr_t packageColor(int pkgIdx) {
+    attr_t attr = COLOR_PAIR(4 + pkgIdx % PACKAGE_COLORS);
+    return (pkgIdx / PACKAGE_COLORS) % 2 ? attr | A_BOLD : attr;
+}
 
-// Map initialization helper functions
-void Gameplay::initializeMap() {
-    mapGrid.assign(map_size, std::string(map_size, '.'));
-
-    // Top and Bottom borders
-    for (int x = 0; x < map_size; ++x) {
-        mapGrid[0][x] = '-';
-        mapGrid[map_size - 1][x] = '-';
-    }
-    // Left and Right borders
-    for (int y = 1; y < map_size - 1; ++y) {
-        mapGrid[y][0] = '|';
-        mapGrid[y][map_size - 1] = '|';
-    }
-    // Corners
-    mapGrid[0][0] = '+';
-    mapGrid[0][map_size - 1] = '+';
-    mapGrid[map_size - 1][0] = '+';
-    mapGrid[map_size - 1][map_size - 1] = '+';
-
-    // Seed
-    srand(time(0));
-
-    // Create a random number engine for std::shuffle
-    std::random_device rd;
-    std::mt19937 g(rd());
-
-    // Reset Delivered Count for New Round
-    packagesDelivered = 0;
-    packagePickUpLocs.clear();
-    packageDestLocs.clear();
-    packagePickUpLocs.resize(num_pkg);
-    packageDestLocs.resize(num_pkg);
-    supplyStationLocations.clear();
-    speedBumpLocations.clear();
-
-    // Define Player Start and Exit Locations
-    playerY = map_size / 2;
-    playerX = 1;
-    exitY = map_size / 2;
-    exitX = map_size - 2;
-    mapGrid[exitY][exitX] = 'Q';  // Place exit marker
-
-    // Helper Lambdas
-    auto isValidInner = [&](int r, int c) {
-        return r > 0 && r < map_size - 1 && c > 0 && c < map_size - 1;
-    };
-    auto isOccupiedOrProtected = [&](int r, int c) {
-        if (!isValidInner(r, c))
-            return true;
-        if (mapGrid[r][c] != '.')
-            return true;
-        if (r == playerY && c == playerX)
-            return true;
-        if (r == exitY && c == exitX)
-            return true;
-        for (const auto& loc : packagePickUpLocs)
-            if (r == loc.first && c == loc.second)
-                return true;
-        for (const auto& loc : packageDestLocs)
-            if (r == loc.first && c == loc.second)
-                return true;
-        return false;
-    };
-    auto isValidObstacle = [&](int r, int c) {
-        if (!(r > 1 && r < map_size - 2 && c > 1 && c < map_size - 2))
-            return false;
-        for (int dr = -1; dr < 2; dr++) {
-            for (int dc = -1; dc < 2; dc++) {
-                int nr = r + dr;
-                int nc = c + dc;
-                if (nr >= 0 && nr < map_size && nc >= 0 && nc < map_size) {
-                    if (mapGrid[nr][nc] == '#')
-                        return false;
-                }
-            }
-        }
-        return true;
-    };
-
-    // Generate Package Pickup Locations
-    int packagesPlaced = 0;
-    while (packagesPlaced < num_pkg) {
-        int y = (rand() % (map_size - 2)) + 1;
-        int x = (rand() % (map_size - 2)) + 1;
-        if (mapGrid[y][x] == '.' && !(y == playerY && x == playerX)) {
-            bool validPackageLocation = true;
-            for (int i = 0; i < packagesPlaced; ++i) {
-                if ((packagePickUpLocs[i].first == y && packagePickUpLocs[i].second == x) ||
-                    invalidPackageDistance(y, x, i)) {
-                    validPackageLocation = false;
-                    break;
-                }
-            }
-            if (validPackageLocation) {
-                packagePickUpLocs[packagesPlaced] = {y, x};
-                mapGrid[y][x] = 'O';
-                packagesPlaced++;
-            }
-        }
-    }
-
-    // Generate Corresponding Destination Locations
-    int destinationsPlaced = 0;
-    while (destinationsPlaced < num_pkg) {
-        int y = (rand() % (map_size - 2)) + 1;
-        int x = (rand() % (map_size - 2)) + 1;
-        if (mapGrid[y][x] == '.') {
-            bool already_chosen = false;
-            bool tooCloseToDestination = false;
-            if (invalidDestinationDistance(y, x, destinationsPlaced)) {
-                tooCloseToDestination = true;
-            }
-            for (int i = 0; i < destinationsPlaced; ++i) {
-                if (packageDestLocs[i].first == y && packageDestLocs[i].second == x) {
-                    already_chosen = true;
-                    break;
-                }
-            }
-            if (!(already_chosen || tooCloseToDestination)) {
-                packageDestLocs[destinationsPlaced] = {y, x};
-                mapGrid[y][x] = 'X';
-                destinationsPlaced++;
-            }
-        }
-    }
-
-    // Obstacle Generation
-    int obstaclePlaced = 0;
-
-    int numObstaclesToPlace = 3;  // Default Easy
-    int numClusters = 3;
-    int clusterSize = 2;      // Default Easy
-    int maxBlocksPerRow = 2;  // Default Easy
-    int maxObstacleLength = 5;
-    int minObstacleLength = 3;
-
-    if (difficultyHighlight == 1) {  // Medium
-        numObstaclesToPlace = 4;
-        clusterSize = 3;
-        maxBlocksPerRow = 3;
-        minObstacleLength = 7;
-        maxObstacleLength = 10;
-    } else if (difficultyHighlight == 2) {  // Hard
-        numObstaclesToPlace = 5;
-        clusterSize = 4;
-        maxBlocksPerRow = 4;
-        minObstacleLength = 8;
-        maxObstacleLength = 12;
-    }
-
-    // Stripes placement
-    int maxPlacementAttempts = map_size * map_size * 2;  // Limit attempts
-    int placementAttempts = 0;
-
-    while (obstaclePlaced < numObstaclesToPlace && placementAttempts < maxPlacementAttempts) {
-        placementAttempts++;
-        bool horizontal = (rand() % 2 == 0);  // Random orientation
-        int len = minObstacleLength +
-                  (rand() % (maxObstacleLength - minObstacleLength + 1));  // Random length
-
-        int startY = (rand() % (map_size - len - 2)) + 1;
-        int startX = (rand() % (map_size - len - 2)) + 1;
-
-        bool canPlace = true;
-        std::vector<std::pair<int, int>> currentObstacleCoords;
-
-        for (int i = 0; i < len; ++i) {
-            int currentY = startY + (horizontal ? 0 : i);
-            int currentX = startX + (horizontal ? i : 0);
-
-            if (!isValidObstacle(currentY, currentX) || mapGrid[currentY][currentX] != '.') {
-                canPlace = false;
-                break;  // Stop checking this potential obstacle
-            }
-            currentObstacleCoords.push_back({currentY, currentX});
-        }
+// Session history log, next to savegame.txt; removed when the game ends. The process id in
+// the name keeps two games started in the same directory from sharing (and deleting) one log.
+std::string historyLogPath() {
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = static_cast<int>(getpid());
+#endif
+    return "gamehistory." + std::to_string(pid) + ".log";
+}
 
-        if (canPlace) {
-            for (const auto& coord : currentObstacleCoords) {
-                mapGrid[coord.first][coord.second] = '#';
-            }
+// History records hold 32-bit values
+int historyValue(long long value) {
+    return static_cast<int>(std::max<long long>(INT_MIN, std::min<long long>(INT_MAX, value)));
+}
 
-            obstaclePlaced++;
+// Legend panel text, "" for a blank line
+constexpr const char* LEGEND_LINES[] = {
+    "--- Legend ---",
+    " @: Player",
+    " #: Obstacle",
+    " ~: Speed Bump",
+    " [$]: Supply Station",
+    " O: Package",
+    " X: Destination",
+    " Q: Exit",
+    "",
+    "--- Movement ---",
+    "   W: Move Up",
+    "   S: Move Down",
+    "   A: Move Left",
+    "   D: Move Right",
+    "  7D: Move 7 tiles",
+    "",
+    "--- Package ---",
+    "   Q: Pick Up",
+    "   E: Drop current",
+    " N/P: Next/prev held",
+    "   #: Select by number",
+    "",
+    "---- Game ----",
+    " Enter: Next Level (at Q)",
+    " PgUp/PgDn: Scroll history",
+    " /: Search history",
+    " ESC: Exit to Menu",
+};
+const int LEGEND_LINE_COUNT = sizeof(LEGEND_LINES) / sizeof(LEGEND_LINES[0]);
+
+// Map cell of each tile kind (glyph and color), indexed by Tile. Packages and destinations
+// are colored by the cell's id instead, which idColorMask lets through for them alone, so a
+// row is composed with two lookups per tile and no branches.
+const int TILE_KINDS = static_cast<int>(Tile::SPEED_BUMP) + 1;
+
+struct TilePalette {
+    chtype cell[TILE_KINDS];
+    chtype idColorMask[TILE_KINDS];
+
+    TilePalette() {
+        for (int t = 0; t < TILE_KINDS; ++t) {
+            Tile tile = static_cast<Tile>(t);
+            chtype attr = A_NORMAL;  // Exit, obstacles and borders keep the default color
+            if (tile == Tile::FLOOR)
+                attr = COLOR_PAIR(3);
+            else if (isStationTile(tile))
+                attr = COLOR_PAIR(9);  // Only active stations are left on the grid
+            else if (tile == Tile::SPEED_BUMP)
+                attr = COLOR_PAIR(10);
+            cell[t] = static_cast<unsigned char>(tileGlyph(tile)) | attr;
+            idColorMask[t] = (tile == Tile::PICKUP || tile == Tile::DESTINATION) ? ~chtype(0) : 0;
         }
     }
+};
+const TilePalette TILE_PALETTE;
 
-    // Blocks placement
-    int clustersPlaced = 0;
-    int maxClusterAttempts = map_size * map_size;
-    int clusterAttempts = 0;
-
-    while (clustersPlaced < numClusters && clusterAttempts < maxClusterAttempts) {
-        clusterAttempts++;
-
-        // Select a random starting position for this cluster
-        int startY = (rand() % (map_size - clusterSize - 2)) + 1;
-        int startX = (rand() % (map_size - clusterSize - 2)) + 1;
-
-        // Check if the entire area is valid for a cluster
-        bool validClusterArea = false;
-        for (int dy = 0; dy < clusterSize && !validClusterArea; dy++) {
-            for (int dx = 0; dx < clusterSize && !validClusterArea; dx++) {
-                int y = startY + dy;
-                int x = startX + dx;
-                if (isValidObstacle(y, x)) {
-                    validClusterArea = true;
-                    break;
-                }
-            }
-        }
-
-        if (!validClusterArea)
-            continue;
-
-        // Check if the area is free of other obstacles
-        bool canPlaceCluster = true;
-        for (int dy = 0; dy < clusterSize && canPlaceCluster; dy++) {
-            for (int dx = 0; dx < clusterSize && canPlaceCluster; dx++) {
-                int y = startY + dy;
-                int x = startX + dx;
-                if (isOccupiedOrProtected(y, x)) {
-                    canPlaceCluster = false;
-                }
-            }
-        }
+chtype mapCell(Tile tile, uint16_t id) {
+    int t = static_cast<int>(tile);
+    return TILE_PALETTE.cell[t] | (packageColor(id) & TILE_PALETTE.idColorMask[t]);
+}
 
-        if (canPlaceCluster) {
-            // Skip individual isValidObstacle checks
-            bool placedAnyBlocks = false;
+const chtype PLAYER_CELL = '@' | COLOR_PAIR(2) | A_BOLD;
 
-            // Generate pattern
-            for (int dy = 0; dy < clusterSize; dy++) {
-                int blocksInRow = 1 + (rand() % maxBlocksPerRow);
-                blocksInRow = std::min(blocksInRow, clusterSize);
+// A drag on the terminal edge sends a burst of resizes; they are taken as one once no new one
+// has come for this long
+const int RESIZE_SETTLE_MS = 50;
 
-                std::vector<int> positions;
-                for (int i = 0; i < clusterSize; i++) {
-                    positions.push_back(i);
-                }
-                // Shuffle to randomize position selection
-                std::shuffle(positions.begin(), positions.end(), g);
-
-                // Place blocks directly without checking isValidObstacle again
-                for (int b = 0; b < blocksInRow; b++) {
-                    int y = startY + dy;
-                    int x = startX + positions[b];
-
-                    if (!isOccupiedOrProtected(y, x)) {
-                        mapGrid[y][x] = '#';
-                        placedAnyBlocks = true;
-                    }
-                }
-            }
+// Longest count a move can be given
+const int MAX_MOVE_COUNT = 999;
 
-            if (placedAnyBlocks) {
-                clustersPlaced++;
-            }
-        }
-    }
+void placeWindow(WINDOW* win, const PanelRect& rect) {
+    int y, x, height, width;
+    getbegyx(win, y, x);
+    getmaxyx(win, height, width);
+    if (height != rect.height || width != rect.width)
+        wresize(win, rect.height, rect.width);
+    if (y != rect.y || x != rect.x)
+        mvwin(win, rect.y, rect.x);
+}
 
-    // --- Place Supply Station [$] ---
-    int numStationsToPlace = 1;      // Default Easy
-    if (difficultyHighlight == 1) {  // Medium
-        numStationsToPlace = 2;
-    } else if (difficultyHighlight == 2) {  // Hard
-        numStationsToPlace = 3;
+int decimalDigits(int n) {
+    int digits = 1;
+    for (; n >= 10; n /= 10) {
+        digits++;
     }
+    return digits;
+}
 
-    int stationsPlaced = 0;
-    int supplyAttempts = 0;
-    int maxSupplyAttempts = map_size * map_size * 2;
-
-    while (stationsPlaced < numStationsToPlace && supplyAttempts < maxSupplyAttempts) {
-        supplyAttempts++;
-        int y = (rand() % (map_size - 2)) + 1;
-        int x = (rand() % (map_size - 4)) + 1;
-
-        if (mapGrid[y][x] == '.' && !isOccupiedOrProtected(y, x) && mapGrid[y][x + 1] == '.' &&
-            !isOccupiedOrProtected(y, x + 1) && mapGrid[y][x + 2] == '.' &&
-            !isOccupiedOrProtected(y, x + 2)) {
-            mapGrid[y][x] = '[';
-            mapGrid[y][x + 1] = '$';
-            mapGrid[y][x + 2] = ']';
+}  // namespace
 
-            supplyStationLocations.push_back({y, x});
-            stationsPlaced++;
-        }
+// Map initialization helper functions
+void Gameplay::initializeMap() {
+    // Generation itself is headless and only depends on the difficulty and the round seed.
+    // A pregenerated pool answers instantly; otherwise the level was normally prefetched
+    // during the previous round.
+    Level level;
+    if (!levelPool.levelForSeed(roundSeed(sessionSeed, core.roundNumber), level)) {
+        DifficultyProfile profile = profileForDifficulty(difficultyHighlight);
+        level = levelPrefetcher.take(profile, roundSeed(sessionSeed, core.roundNumber));
+
+        // Start on the next round while this one is being played
+        levelPrefetcher.start(profile, roundSeed(sessionSeed, core.roundNumber + 1));
     }
 
-    // --- Place Speed Bumps [~] ---
-    int numPatches;
-    int minY, maxY;
-    int minX, maxX;
-
-    switch (difficultyHighlight) {
-        case 0:                             // Easy
-            numPatches = 2 + (rand() % 2);  // 2-3 patches
-            minY = 2;
-            maxY = 4;
-            minX = 2;
-            maxX = 4;
-            break;
-
-        case 1:                             // Medium
-            numPatches = 3 + (rand() % 2);  // 3-4 patches
-            minY = 3;
-            maxY = 5;
-            minX = 3;
-            maxX = 5;
-            break;
-
-        case 2:                             // Hard
-            numPatches = 4 + (rand() % 2);  // 4-5 patches
-            minY = 4;
-            maxY = 6;
-            minX = 4;
-            maxX = 6;
-            break;
+    // Reset the round's player, cargo and counters
+    startRound(core, level);
+    packageScroll = 0;
+    mapCells.assign(core.grid.height() * core.grid.width() * 2, ' ');
+    steadyFrame = false;  // Taking over the level's storage frees the old one
+    redrawAllPanels();
+    roundClock.restart();
+}
 
-        default:
-            numPatches = 2 + (rand() % 2);
-            minY = 1;
-            maxY = 4;
-            minX = 2;
-            maxX = 4;
-            break;
+// Constructor initializes windows based on difficulty
+Gameplay::Gameplay(const int& difficultyHighlight, GameState& current_state, bool isNewGame,
+                   bool dailyChallenge)
+    : current_state(current_state),
+      difficultyHighlight(difficultyHighlight),
+      map_size(0),
+      history(historyLogPath()),
+      historyScroll(0),
+      historyMatch(-1),
+      historyNoMatch(false),
+      rewardRng(0, RngStream::REWARDS),
+      dailyChallenge(dailyChallenge),
+      packageScroll(0),
+      moveCount(0),
+      dirtyPanels(ALL_PANELS),
+      panelsRepainted(0),
+      shownSecond(-1),
+      mapStale(true),
+      changedCellCount(0),
+      drawnPlayerY(0),
+      drawnPlayerX(0),
+      layoutHeight(-1),
+      layoutWidth(-1),
+      layoutRowWidth(-1),
+      steadyFrame(false),
+      frameAllocations(0),
+      allocatingFrames(0) {
+    historyQuery[0] = '\0';
+    // Every round's map is derived from this seed
+    if (dailyChallenge) {
+        sessionSeed = dailySeed();
+    } else {
+        std::random_device rd;
+        sessionSeed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
     }
+    rewardRng = Rng(sessionSeed, RngStream::REWARDS);
 
-    int patchesPlaced = 0;
-    int maxAttempts = map_size * map_size * 2;
-    int attempts = 0;
-
-    while (patchesPlaced < numPatches && attempts < maxAttempts) {
-        attempts++;
-
-        int patchRows = minY + (rand() % (maxY - minY + 1));
-
-        int patchStartY = (rand() % (map_size - patchRows - 2)) + 1;
-        int patchStartX = (rand() % (map_size - maxX - 2)) + 1;
-
-        bool placedPatch = false;
-
-        for (int row = 0; row < patchRows; row++) {
-            // Randomize starting x with slight offset
-            int rowStartX = patchStartX + rand() % 3;  // 0, 1 or 2 offset
-
-            int rowLength = minX + (rand() % (maxX - minX + 1));
-
-            for (int col = 0; col < rowLength; col++) {
-                int y = patchStartY + row;
-                int x = rowStartX + col;
-
-                if (!isOccupiedOrProtected(y, x)) {
-                    mapGrid[y][x] = '~';
-                    speedBumpLocations.push_back({y, x});
-                    placedPatch = true;
-                }
-            }
-        }
-
-        if (placedPatch)
-            patchesPlaced++;
+    // A missing or mismatched pool just leaves it closed. The daily challenge never uses one:
+    // its maps must come from the date alone, not from whichever pool file is installed
+    if (!dailyChallenge) {
+        levelPool.open(levelPoolPath(difficultyHighlight),
+                       profileForDifficulty(difficultyHighlight));
     }
 
-    stepsTakenThisRound = 0;
-    startTime = std::chrono::steady_clock::now();
-}
-
-// Constructor initializes windows based on difficulty
-Gameplay::Gameplay(const int& difficultyHighlight, GameState& current_state, bool isNewGame)
-    : difficultyHighlight(difficultyHighlight),
-      current_state(current_state),
-      map_size(0),
-      num_obs(0),
-      num_pkg(0),
-      roundNumber(1),
-      currentStamina(200),
-      maxStamina(200),
-      staminaAtRoundStart(200),
-      stepsTakenThisRound(0),
-      totalScore(0),
-      lastRoundStepScore(0),
-      lastRoundTimeScore(0),
-      currentPackageIndex(-1),
-      packagesDelivered(0),
-      playerY(0),
-      playerX(0),
-      exitY(0),
-      exitX(0),
-      doubleStaminaCostNextMove(false) {
     if (isNewGame) {
-        // Initialize as a new game
-        roundNumber = 1;
-        currentStamina = 200;
-        maxStamina = 200;
-        staminaAtRoundStart = 200;
-        totalScore = 0;
-        lastRoundStepScore = 0;
-        lastRoundTimeScore = 0;
-        updateDifficultyVariables();
+        startNewGame();
     } else {
         // Load from save file
         loadGameState();
     }
 
-    hasPackage.resize(num_pkg, false);
-
     // Initialize the map grid
     initializeMap();
 
@@ -441,6 +239,16 @@ Gameplay::Gameplay(const int& difficultyHighlight, GameState& current_state, boo
     historyWin = newwin(1, 1, 0, 0);
     packageWin = newwin(3, 1, 0, 0);
 
+    // The legend never changes, so its text is laid out once
+    int legendTextWidth = 1;
+    for (const char* line : LEGEND_LINES) {
+        legendTextWidth = std::max(legendTextWidth, static_cast<int>(std::strlen(line)));
+    }
+    legendPad = newpad(LEGEND_LINE_COUNT, legendTextWidth);
+    for (int i = 0; i < LEGEND_LINE_COUNT; ++i) {
+        mvwaddstr(legendPad, i, 0, LEGEND_LINES[i]);
+    }
+
     keypad(stdscr, TRUE);
 }
 
@@ -456,149 +264,74 @@ Gameplay::~Gameplay() {
     delwin(staminaWin);
     delwin(historyWin);
     delwin(packageWin);
+    delwin(legendPad);
 
     clear();
     refresh();
 }
 
 void Gameplay::updateDifficultyVariables() {
-    switch (difficultyHighlight) {
-        case 0:  // Easy
-            diff_str = "Easy";
-            map_size = 15;
-            num_obs = 5;
-            num_pkg = 3;
-            break;
-        case 1:  // Medium
-            diff_str = "Medium";
-            maxStamina = 270;
-            currentStamina = 270;
-            map_size = 20;  // Same above
-            num_obs = 6;
-            num_pkg = 4;
-            break;
-        case 2:  // Hard
-            diff_str = "Hard";
-            maxStamina = 350;
-            currentStamina = 350;
-            map_size = 25;
-            num_obs = 7;
-            num_pkg = 5;
-            break;
-        default:
-            diff_str = "Unknown";
-            map_size = 15;
-            num_obs = 5;
-            num_pkg = 3;
-            break;
-    }
+    const DifficultySettings& settings = difficultySettings(difficultyHighlight);
+    diff_str = settings.name;
+    core.maxStamina = settings.startStamina;  // The stamina cap
+    map_size = settings.profile.mapSize;
+    core.numPackages = settings.profile.numPackages;
+}
+
+// Round 1 with the difficulty's starting stamina
+void Gameplay::startNewGame() {
+    const int startStamina = difficultySettings(difficultyHighlight).startStamina;
+    core.roundNumber = 1;
+    core.stamina = startStamina;
+    core.staminaAtRoundStart = startStamina;
+    core.totalScore = 0;
+    core.lastRoundStepScore = 0;
+    core.lastRoundTimeScore = 0;
+    updateDifficultyVariables();
 }
 
 void Gameplay::resizeWindows() {
     getmaxyx(stdscr, height, width);
+    int packageRowWidth = core.numPackages * (decimalDigits(core.numPackages) + 1);
+    if (height == layoutHeight && width == layoutWidth && packageRowWidth == layoutRowWidth)
+        return;
+    layoutHeight = height;
+    layoutWidth = width;
+    layoutRowWidth = packageRowWidth;
+
+    // Only windows whose place changed are touched
+    GameLayout layout = computeLayout(height, width, map_size, packageRowWidth);
+    placeWindow(mapWin, layout.map);
+    placeWindow(legendWin, layout.legend);
+    placeWindow(historyWin, layout.history);
+    placeWindow(timeWin, layout.time);
+    placeWindow(statsWin, layout.stats);
+    placeWindow(staminaWin, layout.stamina);
+    placeWindow(packageWin, layout.package);
+    redrawAllPanels();
+}
 
-    // Recalculate window positions and sizes
-    // --- Map Window ---
-    int mapHeight = map_size;
-    int mapWidth = map_size * 2;
-    int mapY = std::max(0, (height - mapHeight) / 2);
-    int mapX = std::max(0, (width - mapWidth) / 2);
-
-    // --- Side Panel Widths ---
-    int sidePanelWidth = width / 4;
-    int legendWidth = sidePanelWidth;
-    int timeWidth = sidePanelWidth;
-    int statsWidth = sidePanelWidth;
-    int historyWidth = legendWidth;
-
-    // --- Bottom Panel Heights ---
-    int bottomPanelHeight = 3;  // Common height for stamina and package
-
-    // --- Calculate Bottom Panel Widths ---
-    int staminaWidth = std::max(20, width / 3);
-    // Calculate desired package width
-    int packageWidth = 4 + (num_pkg * 2) + 4;
-    packageWidth = std::max(15, packageWidth);
-
-    // --- Adjust widths if total exceeds screen width ---
-    int totalBottomWidth = staminaWidth + packageWidth;
-    if (totalBottomWidth > width) {
-        double ratio = static_cast<double>(width) / totalBottomWidth;
-        staminaWidth = std::max(10, static_cast<int>(staminaWidth * ratio));
-        packageWidth = width - staminaWidth;  // Give remaining space to package
-        packageWidth = std::max(1, packageWidth);
+// --- Cargo ---
+void Gameplay::selectPackage(int pkgIdx) {
+    if (pkgIdx < 0 || pkgIdx >= core.numPackages) {
+        emit(HistoryEvent::NO_SUCH_PACKAGE);
+        return;
     }
-    staminaWidth = std::max(1, staminaWidth);
-
-    // Centered Starting X for Bottom Panel
-    int bottomStartX = std::max(0, (width - (staminaWidth + packageWidth)) / 2);
-
-    // --- Stamina Window Position  ---
-    int staminaY = height - bottomPanelHeight;
-    int staminaX = bottomStartX;
-
-    // --- Package Window Position  ---
-    int packageHeight = bottomPanelHeight;
-    int packageY = height - bottomPanelHeight;
-    int packageX = staminaX + staminaWidth;
-
-    // --- Side Panel Heights & Positions ---
-    // Left Side
-    int minLegendHeight = 26;
-    int desiredLegendHeight = std::min(height - bottomPanelHeight, height / 2);
-    int legendHeight = std::max(minLegendHeight, desiredLegendHeight);  // Ensure minimum height
-    legendHeight = std::min(height - bottomPanelHeight,
-                            legendHeight);  // Don't exceed available space above bottom bar
-
-    int legendX = 0;
-    int legendY = 0;
-
-    // --- History Window ---
-    int historyY = legendHeight;
-    int historyHeight = std::max(1, height - legendHeight - bottomPanelHeight);
-    int historyX = 0;
-
-    // Right Side
-    int timeHeight = std::min(height - bottomPanelHeight, height / 4);
-    int timeX = std::max(0, width - timeWidth);
-    int timeY = 0;
-
-    int statsX = timeX;
-    int statsY = timeY + timeHeight;
-    int statsHeight = std::max(1, height - timeHeight - bottomPanelHeight);
-
-    // --- Resize and Reposition ---
-    wresize(mapWin, mapHeight, mapWidth);
-    mvwin(mapWin, mapY, mapX);
-
-    wresize(legendWin, legendHeight, legendWidth);
-    mvwin(legendWin, legendY, legendX);
-
-    wresize(historyWin, historyHeight, historyWidth);
-    mvwin(historyWin, historyY, historyX);
-
-    wresize(timeWin, timeHeight, timeWidth);
-    mvwin(timeWin, timeY, timeX);
-
-    wresize(statsWin, statsHeight, statsWidth);
-    mvwin(statsWin, statsY, statsX);
-
-    // Note: With the map centered, the side panels (Legend, Time, Stats)
-    // might overlap the map if the terminal width is not large enough
-    // maybe will carryout a check here to ensure that the map is not overlapped
-    // Reposition Stamina window using bottomStartX
-    wresize(staminaWin, bottomPanelHeight, staminaWidth);
-    mvwin(staminaWin, staminaY, staminaX);
-
-    // Reposition Package window using calculated packageX
-    wresize(packageWin, packageHeight, packageWidth);
-    mvwin(packageWin, packageY, packageX);
+    emit(HistoryEvent::PACKAGE_SELECTED, pkgIdx + 1);
 }
 
 // --- Input handling ---
 void Gameplay::handleInput(int ch) {
-    int nextY = playerY;
-    int nextX = playerX;
+    // Digits build up a count for the next move
+    if (ch >= '0' && ch <= '9' && (moveCount > 0 || ch != '0')) {
+        moveCount = std::min(MAX_MOVE_COUNT, moveCount * 10 + (ch - '0'));
+        return;
+    }
+    int steps = std::max(1, moveCount);
+    moveCount = 0;
+
+    int nextY = core.playerY;
+    int nextX = core.playerX;
     bool moved = false;
 
     switch (ch) {
@@ -626,85 +359,49 @@ void Gameplay::handleInput(int ch) {
         // --- Exit Interaction ---
         case '\n':       // Enter key
         case KEY_ENTER:  // Ncurses specific Enter key
-            if (playerY == exitY && playerX == exitX) {
+            if (core.playerY == core.exitY && core.playerX == core.exitX) {
                 // Check if all packages are delivered
-                if (packagesDelivered >= num_pkg) {
+                if (core.packagesDelivered >= core.numPackages) {
                     // --- Calculate Stats & Score ---
-                    int staminaReward;
                     // More stamina reward for higher difficulty considering game balance
-                    switch (difficultyHighlight) {
-                        case 0:  // Easy
-                            staminaReward = 75;
-                            break;
-                        case 1:  // Medium
-                            staminaReward = 100;
-                            break;
-                        case 2:  // Hard
-                            staminaReward = 150;
-                            break;
-                        default:
-                            staminaReward = 75;
-                    }
-                    int oldStamina = currentStamina;
-                    int finalStamina = std::min(maxStamina, currentStamina + staminaReward);
-                    int staminaUsedThisRound = std::max(0, staminaAtRoundStart - oldStamina);
-
-                    auto now = std::chrono::steady_clock::now();
-                    auto elapsed =
-                        std::chrono::duration_cast<std::chrono::seconds>(now - startTime);
-                    long long timeTaken = elapsed.count();
+                    int staminaReward = difficultySettings(difficultyHighlight).roundReward;
+                    int staminaUsedThisRound =
+                        std::max(0, core.staminaAtRoundStart - core.stamina);
+                    int stepsTaken = core.stepsThisRound;
 
-                    // --- Scoring ---
-                    // Define base scores and penalties
-                    const int BASE_STEP_SCORE = 1000;
-                    const int STEP_PENALTY = 5;
-                    const int BASE_TIME_SCORE = 1000;
-                    const int TIME_PENALTY = 2;
+                    long long timeTaken = roundClock.elapsedSeconds();
 
-                    int stepScore =
-                        std::max(0, BASE_STEP_SCORE - (stepsTakenThisRound * STEP_PENALTY));
-                    int timeScore =
-                        std::max(0, BASE_TIME_SCORE - (static_cast<int>(timeTaken) * TIME_PENALTY));
-                    int roundScore = stepScore + timeScore;
-
-                    lastRoundStepScore = stepScore;
-                    lastRoundTimeScore = timeScore;
+                    // --- Scoring ---
+                    RoundScore score = scoreRound(core.stepsThisRound, timeTaken);
+                    int stepScore = score.stepScore;
+                    int timeScore = score.timeScore;
+                    int roundScore = score.total;
 
-                    totalScore += roundScore;
+                    // Scores and the stamina reward land in the state before the popup shows
+                    emit(HistoryEvent::LEVEL_COMPLETE, staminaReward, roundScore, stepScore,
+                         timeScore);
 
                     // --- Prepare Popup Message ---
                     std::vector<std::string> popupLines;
-                    popupLines.push_back("Round " + std::to_string(roundNumber) + " Complete!");
+                    popupLines.push_back("Round " + std::to_string(core.roundNumber) + " Complete!");
                     popupLines.push_back("");
                     popupLines.push_back("Time Taken: " + std::to_string(timeTaken) +
                                          "s (Score: " + std::to_string(timeScore) + ")");
-                    popupLines.push_back("Steps Taken: " + std::to_string(stepsTakenThisRound) +
+                    popupLines.push_back("Steps Taken: " + std::to_string(stepsTaken) +
                                          " (Score: " + std::to_string(stepScore) + ")");
                     popupLines.push_back("Stamina Used: " + std::to_string(staminaUsedThisRound));
                     popupLines.push_back("Stamina Bonus: +" + std::to_string(staminaReward));
                     popupLines.push_back("Round Score: " + std::to_string(roundScore));
-                    popupLines.push_back("Total Score: " + std::to_string(totalScore));
+                    popupLines.push_back("Total Score: " + std::to_string(core.totalScore));
 
                     // --- Display Popup ---
                     displayPopupMessage("Level Complete", popupLines);
 
-                    // --- Apply Reward and Proceed ---
-                    currentStamina = finalStamina;
-                    staminaAtRoundStart = currentStamina;
-                    addHistoryMessage("Level Complete! +" + std::to_string(staminaReward) +
-                                      " stamina bonus. Round Score: " + std::to_string(roundScore));
-                    roundNumber++;
-                    addHistoryMessage("Proceeding to Round " + std::to_string(roundNumber) + "...");
+                    // --- Proceed ---
+                    emit(HistoryEvent::NEXT_ROUND, core.roundNumber + 1);
                     initializeMap();
-
-                    std::fill(hasPackage.begin(), hasPackage.end(), false);
-                    currentPackageIndex = -1;
-                    doubleStaminaCostNextMove = false;
-
                 } else {
-                    addHistoryMessage("Cannot exit yet! Deliver all packages first. (" +
-                                      std::to_string(packagesDelivered) + "/" +
-                                      std::to_string(num_pkg) + " delivered)");
+                    emit(HistoryEvent::EXIT_BLOCKED, core.packagesDelivered, core.numPackages);
                 }
             } else {
                 // Optional: Message if Enter pressed not at exit
@@ -712,120 +409,68 @@ void Gameplay::handleInput(int ch) {
             break;
 
         // --- Package Selection ---
-        case '1':
-            if (num_pkg >= 1)
-                currentPackageIndex = 0;
-            addHistoryMessage("Selected package 1.");
-            break;
-        case '2':
-            if (num_pkg >= 2)
-                currentPackageIndex = 1;
-            addHistoryMessage("Selected package 2.");
-            break;
-        case '3':
-            if (num_pkg >= 3)
-                currentPackageIndex = 2;
-            addHistoryMessage("Selected package 3.");
-            break;
-        case '4':
-            if (num_pkg >= 4)
-                currentPackageIndex = 3;
-            addHistoryMessage("Selected package 4.");
-            break;
-        case '5':
-            if (num_pkg >= 5)
-                currentPackageIndex = 4;
-            addHistoryMessage("Selected package 5.");
+        case '#': {
+            int number = promptPackageNumber();
+            if (number > 0)
+                selectPackage(number - 1);
+        } break;
+        case 'n':
+        case 'p':
+            // Cycle through the packages being carried
+            if (core.heldPackages == 0) {
+                emit(HistoryEvent::NOTHING_HELD);
+            } else {
+                selectPackage(nextHeldPackage(core, core.currentPackageIndex, ch == 'n'));
+            }
             break;
 
         // --- Package Pickup ---
         case 'q': {
-            bool foundPackage = false;
-            for (int i = 0; i < num_pkg; ++i) {
-                // Check if player is at pickup location i AND it's still on the map
-                if (playerY == packagePickUpLocs[i].first &&
-                    playerX == packagePickUpLocs[i].second && mapGrid[playerY][playerX] == 'O') {
-                    if (!hasPackage[i]) {
-                        hasPackage[i] = true;
-                        mapGrid[playerY][playerX] = '.';
-                        currentPackageIndex = i;
-                        addHistoryMessage("Picked up package " + std::to_string(i + 1) + ".");
-                        foundPackage = true;
-                    } else {
-                        addHistoryMessage("Already holding package " + std::to_string(i + 1) + ".");
-                        foundPackage = true;
-                    }
-                    break;
-                }
-            }
-            if (!foundPackage && mapGrid[playerY][playerX] == 'O') {
-                addHistoryMessage("Error: Package 'O' found but no matching location data.");
-            } else if (!foundPackage) {
-                addHistoryMessage("No package to pick up here.");
+            int i = core.grid.idAt(core.playerY, core.playerX);
+            if (core.grid.at(core.playerY, core.playerX) != Tile::PICKUP) {
+                emit(HistoryEvent::NO_PACKAGE_HERE);
+            } else if (i >= core.numPackages) {
+                emit(HistoryEvent::PACKAGE_DATA_MISSING);
+            } else if (!isHeld(core, i)) {
+                emit(HistoryEvent::PICKED_UP, i + 1);
+            } else {
+                emit(HistoryEvent::ALREADY_HELD, i + 1);
             }
         } break;
 
         // --- Package Drop ---
         case 'e':
             // Check if a package is selected and held
-            if (currentPackageIndex != -1 && hasPackage[currentPackageIndex]) {
-                int pkgIdx = currentPackageIndex;
+            if (core.currentPackageIndex != -1 && isHeld(core, core.currentPackageIndex)) {
+                int pkgIdx = core.currentPackageIndex;
 
                 // --- Prevent dropping at the exit location ---
-                if (playerY == exitY && playerX == exitX) {
-                    addHistoryMessage("Cannot drop packages at the exit 'Q'.");
+                if (core.playerY == core.exitY && core.playerX == core.exitX) {
+                    emit(HistoryEvent::DROP_AT_EXIT);
                 }
                 // --- Check if the current location is empty ground '.' ---
-                else if (mapGrid[playerY][playerX] == '.') {
-                    // Drop the package
-                    addHistoryMessage("Dropped package " + std::to_string(pkgIdx + 1) + ".");
-                    hasPackage[pkgIdx] = false;
-                    mapGrid[playerY][playerX] = 'O';
-
-                    // Update the pickup location to the drop location
-                    // This ensures the correct color is shown and it can be picked up again
-                    packagePickUpLocs[pkgIdx] = {playerY, playerX};
-
-                    // Find next held package or set to -1
-                    currentPackageIndex = -1;
-                    for (int i = 0; i < num_pkg; ++i) {
-                        if (hasPackage[i]) {
-                            currentPackageIndex = i;
-                            break;
-                        }
-                    }
+                else if (core.grid.at(core.playerY, core.playerX) == Tile::FLOOR) {
+                    // Drop the package; the next held one is selected
+                    emit(HistoryEvent::DROPPED, pkgIdx + 1);
                 }
                 // --- Check if trying to drop at the correct destination 'X' ---
-                else if (playerY == packageDestLocs[pkgIdx].first &&
-                         playerX == packageDestLocs[pkgIdx].second &&
-                         mapGrid[playerY][playerX] == 'X') {
-                    // Deliver the package
-                    addHistoryMessage("Delivered package " + std::to_string(pkgIdx + 1) + "!");
-                    hasPackage[pkgIdx] = false;
-                    packagesDelivered++;
-                    mapGrid[playerY][playerX] = '.';
-
-                    // Find next held package or set to -1
-                    currentPackageIndex = -1;
-                    for (int i = 0; i < num_pkg; ++i) {
-                        if (hasPackage[i]) {
-                            currentPackageIndex = i;
-                            break;
-                        }
-                    }
+                else if (core.grid.at(core.playerY, core.playerX) == Tile::DESTINATION &&
+                         core.grid.idAt(core.playerY, core.playerX) == pkgIdx) {
+                    // Deliver the package; the next held one is selected
+                    emit(HistoryEvent::DELIVERED, pkgIdx + 1);
                     // Add score in the future
                 } else {
-                    addHistoryMessage("Cannot drop package here. Location occupied.");
+                    emit(HistoryEvent::DROP_OCCUPIED);
                 }
             } else {
-                addHistoryMessage("No package selected/held to drop.");
+                emit(HistoryEvent::NOTHING_TO_DROP);
             }
             break;
 
         case 27:  // ESC
             if (displayQuitOptions()) {
                 saveGameState();  // Save game data before quitting
-                addHistoryMessage("Exiting to main menu...");
+                emit(HistoryEvent::EXITING);
 
                 clear();
                 refresh();
@@ -834,13 +479,27 @@ void Gameplay::handleInput(int ch) {
 
                 return;
             } else {
-                addHistoryMessage("Continuing game...");
+                emit(HistoryEvent::CONTINUING);
             }
             break;
+        // --- History ---
+        case KEY_PPAGE:
+            scrollHistory(std::max(1, getmaxy(historyWin) - 2));
+            break;
+        case KEY_NPAGE:
+            scrollHistory(-std::max(1, getmaxy(historyWin) - 2));
+            break;
+        case '/':
+            searchHistory();
+            break;
+
         case KEY_RESIZE:
-            addHistoryMessage("Terminal resized.");
-            clear();
-            refresh();
+            emit(HistoryEvent::RESIZED);
+            steadyFrame = false;
+            // Blank what the old layout left, in the same update as the new one
+            erase();
+            wnoutrefresh(stdscr);
+            redrawAllPanels();
             break;
 
         case ERR:
@@ -851,167 +510,75 @@ void Gameplay::handleInput(int ch) {
     }
 
     // --- Process Movement ---
-    if (moved) {
-        // Check Boundaries
-        if (nextY > 0 && nextY < map_size - 1 && nextX > 0 && nextX < map_size - 1) {
-            // Check Obstacles
-            if (mapGrid[nextY][nextX] != '#') {
-                // --- Calculate Stamina Cost ---
-                int numHeldPackages = 0;
-                for (bool held : hasPackage) {
-                    if (held) {
-                        numHeldPackages++;
-                    }
-                }
-                int baseMoveCost = 1 + numHeldPackages;  // Base cost = 1 + number of packages held
-                int finalMoveCost = baseMoveCost;
+    if (moved)
+        movePlayer(nextY - core.playerY, nextX - core.playerX, steps);
+}
 
-                if (doubleStaminaCostNextMove) {
-                    finalMoveCost *= 2;
-                    doubleStaminaCostNextMove =
-                        false;  // Consume the flag *before* checking stamina
-                }
+// Walk up to `steps` tiles in one direction, as that many single moves would (see
+// walkPlayer()); a walk that ends too tired to go on is checked for a softlock like a single
+// move that cannot be made
+void Gameplay::movePlayer(int dy, int dx, int steps) {
+    WalkResult walk =
+        walkPlayer(core, dy, dx, steps, rewardRng, [this](const HistoryRecord& record) {
+            emit(record.event, record.values[0], record.values[1], record.values[2],
+                 record.values[3]);
+        });
+
+    if (walk.stoppedBy == HistoryEvent::TOO_TIRED) {
+        // --- Check for Softlock Game Over ---
+        // Can the player potentially resolve this by dropping a package?
+        bool canDrop = false;
+        // Check if holding a package AND on an empty '.' spot
+        if (core.currentPackageIndex != -1 && isHeld(core, core.currentPackageIndex) &&
+            core.grid.at(core.playerY, core.playerX) == Tile::FLOOR) {
+            canDrop = true;
+        }
 
-                // Check Stamina (using calculated cost)
-                if (currentStamina >= finalMoveCost) {
-                    int oldStamina = currentStamina;
-                    currentStamina -= finalMoveCost;
-                    currentStamina =
-                        std::max(0, currentStamina);  // Ensure stamina doesn't go below 0
-
-                    // Update Player Position
-                    playerY = nextY;
-                    playerX = nextX;
-                    stepsTakenThisRound++;
-
-                    addHistoryMessage("Moved. Cost: " + std::to_string(finalMoveCost) +
-                                      ". Stamina: " + std::to_string(oldStamina) + " -> " +
-                                      std::to_string(currentStamina));
-
-                    // --- Check for landing on Supply Station ---
-                    for (int i = supplyStationLocations.size() - 1; i >= 0; --i) {
-                        int stationY = supplyStationLocations[i].first;
-                        int stationX = supplyStationLocations[i].second;
-
-                        // Check if player landed on any part of this station
-                        if (playerY == stationY &&
-                            (playerX >= stationX && playerX <= stationX + 2)) {
-                            int staminaGain = (rand() % 41) + 60;  // Ranging from 60-100
-                            int oldStaminaBeforeGain = currentStamina;
-                            currentStamina = std::min(maxStamina, currentStamina + staminaGain);
-                            addHistoryMessage("Supply opened! +" + std::to_string(staminaGain) +
-                                              " stamina. (" + std::to_string(oldStaminaBeforeGain) +
-                                              "->" + std::to_string(currentStamina) + ")");
-
-                            // Remove the supply station from the map grid
-                            mapGrid[stationY][stationX] = '.';
-                            mapGrid[stationY][stationX + 1] = '.';
-                            mapGrid[stationY][stationX + 2] = '.';
-
-                            // Remove the station from the active list
-                            supplyStationLocations.erase(supplyStationLocations.begin() + i);
-
-                            break;  // Player can only use one station per step
-                        }
-                    }
-
-                    // --- Check for landing on Speed Bump ---
-                    if (mapGrid[playerY][playerX] == '~') {
-                        if (!doubleStaminaCostNextMove) {
-                            addHistoryMessage("Stepped on a speed bump! Next move costs double.");
-                            doubleStaminaCostNextMove = true;
-                        }
-                    }
-
-                    // --- Check for Game Over (Stamina Depleted AFTER move) ---
-                    if (currentStamina <= 0) {
-                        // --- Prepare Popup Message ---
-                        auto now = std::chrono::steady_clock::now();
-                        auto elapsed =
-                            std::chrono::duration_cast<std::chrono::seconds>(now - startTime);
-                        long long timeTaken = elapsed.count();
-
-                        std::vector<std::string> popupLines;
-                        popupLines.push_back("You ran out of stamina!");
-                        popupLines.push_back("");
-                        popupLines.push_back("Round Reached: " + std::to_string(roundNumber));
-                        popupLines.push_back("Time This Round: " + std::to_string(timeTaken) + "s");
-                        popupLines.push_back("Steps This Round: " +
-                                             std::to_string(stepsTakenThisRound));
-                        popupLines.push_back("Final Total Score: " + std::to_string(totalScore));
-
-                        // --- Display Popup ---
-                        displayPopupMessage("Game Over", popupLines);
-
-                        // --- Set Game State ---
-                        addHistoryMessage("GAME OVER! You ran out of stamina. Final Score: " +
-                                          std::to_string(totalScore));
-                        current_state = GameState::MAIN_MENU;
-                        return;  // Exit handleInput early
-                    }
-
-                } else {  // Not enough stamina for the attempted move
-                    addHistoryMessage("Cannot move! Need " + std::to_string(finalMoveCost) +
-                                      " stamina, have " + std::to_string(currentStamina) + ".");
-                    // Reset flag if player couldn't make the double-cost move
-
-                    // --- Check for Softlock Game Over ---
-                    // Can the player potentially resolve this by dropping a package?
-                    bool canDrop = false;
-                    // Check if holding a package AND on an empty '.' spot
-                    if (currentPackageIndex != -1 && hasPackage[currentPackageIndex] &&
-                        mapGrid[playerY][playerX] == '.') {
-                        canDrop = true;
-                    }
-
-                    // If stamina is positive, but can't afford the move AND cannot drop a package,
-                    // it's game over.
-                    if (currentStamina > 0 && !canDrop) {
-                        // --- Prepare Popup Message ---
-                        auto now = std::chrono::steady_clock::now();
-                        auto elapsed =
-                            std::chrono::duration_cast<std::chrono::seconds>(now - startTime);
-                        long long timeTaken = elapsed.count();
-
-                        std::vector<std::string> popupLines;
-                        popupLines.push_back("You got stuck with no possible moves!");
-                        popupLines.push_back("(Not enough stamina to move, cannot drop package)");
-                        popupLines.push_back("");
-                        popupLines.push_back("Round Reached: " + std::to_string(roundNumber));
-                        popupLines.push_back("Time This Round: " + std::to_string(timeTaken) + "s");
-                        popupLines.push_back("Steps This Round: " +
-                                             std::to_string(stepsTakenThisRound));
-                        popupLines.push_back("Final Total Score: " + std::to_string(totalScore));
-
-                        // --- Display Popup ---
-                        displayPopupMessage("Game Over", popupLines);
-
-                        // --- Set Game State ---
-                        addHistoryMessage("GAME OVER! Stuck with no possible moves. Final Score: " +
-                                          std::to_string(totalScore));
-                        current_state = GameState::MAIN_MENU;
-                        return;
-                    }
-                    // --- End Softlock Check ---
-
-                    // Reset speed bump flag if player couldn't make the double-cost move
-                    if (finalMoveCost > baseMoveCost)
-                        doubleStaminaCostNextMove = true;  // Put the flag back
-                }
-            } else {  // Hit obstacle
-                addHistoryMessage("Cannot move! Blocked by obstacle.");
-                // If player intended a double-cost move but hit a wall, reset the flag
-                if (doubleStaminaCostNextMove) {
-                    doubleStaminaCostNextMove = false;
-                }
-            }
-        } else {
-            addHistoryMessage("Cannot move! Hit the border.");
-            // If player intended a double-cost move but hit border, reset the flag
-            if (doubleStaminaCostNextMove) {
-                doubleStaminaCostNextMove = false;
-            }
+        // If stamina is positive, but can't afford the move AND cannot drop a package,
+        // it's game over.
+        if (core.stamina > 0 && !canDrop) {
+            // --- Prepare Popup Message ---
+            long long timeTaken = roundClock.elapsedSeconds();
+
+            std::vector<std::string> popupLines;
+            popupLines.push_back("You got stuck with no possible moves!");
+            popupLines.push_back("(Not enough stamina to move, cannot drop package)");
+            popupLines.push_back("");
+            popupLines.push_back("Round Reached: " + std::to_string(core.roundNumber));
+            popupLines.push_back("Time This Round: " + std::to_string(timeTaken) + "s");
+            popupLines.push_back("Steps This Round: " + std::to_string(core.stepsThisRound));
+            popupLines.push_back("Final Total Score: " + std::to_string(core.totalScore));
+
+            // --- Display Popup ---
+            displayPopupMessage("Game Over", popupLines);
+
+            // --- Set Game State ---
+            emit(HistoryEvent::STUCK, historyValue(core.totalScore));
+            current_state = GameState::MAIN_MENU;
         }
+        // --- End Softlock Check ---
+        return;
+    }
+
+    // --- Check for Game Over (Stamina Depleted AFTER move) ---
+    if (walk.steps > 0 && core.stamina <= 0) {
+        // --- Prepare Popup Message ---
+        long long timeTaken = roundClock.elapsedSeconds();
+
+        std::vector<std::string> popupLines;
+        popupLines.push_back("You ran out of stamina!");
+        popupLines.push_back("");
+        popupLines.push_back("Round Reached: " + std::to_string(core.roundNumber));
+        popupLines.push_back("Time This Round: " + std::to_string(timeTaken) + "s");
+        popupLines.push_back("Steps This Round: " + std::to_string(core.stepsThisRound));
+        popupLines.push_back("Final Total Score: " + std::to_string(core.totalScore));
+
+        // --- Display Popup ---
+        displayPopupMessage("Game Over", popupLines);
+
+        // --- Set Game State ---
+        emit(HistoryEvent::OUT_OF_STAMINA, historyValue(core.totalScore));
+        current_state = GameState::MAIN_MENU;
     }
 }
 
@@ -1037,29 +604,51 @@ void Gameplay::run() {
         init_pair(10, COLOR_YELLOW, COLOR_BLACK);  // Speed Bump [~]
     }
 
-    addHistoryMessage("Game Started. Round " + std::to_string(roundNumber));
-    startTime = std::chrono::steady_clock::now();
+    emit(HistoryEvent::GAME_STARTED, core.roundNumber);
+    if (dailyChallenge)
+        emit(HistoryEvent::DAILY_CHALLENGE);
+    roundClock.restart();
 
+    int lastHeight = -1;
+    int lastWidth = -1;
     while (current_state != GameState::MAIN_MENU) {
+        size_t allocationsBefore = allocationCount();
         getmaxyx(stdscr, height, width);
 
-        // Stage changes done to windows
-        resizeWindows();
-        displayMap();
-        displayStats();
-        displayTime();
-        displayLegend();
-        displayStaminaBar();
-        displayHistory();
-        displayPackages();
+        // Only a frame at an unchanged terminal size may be steady (wresize allocates)
+        steadyFrame = (height == lastHeight && width == lastWidth);
+        lastHeight = height;
+        lastWidth = width;
 
-        // Update all windows at once
-        doupdate();
+        // Stage changes done to windows, then update the repainted ones at once
+        resizeWindows();
+        if (repaintPanels() > 0)
+            doupdate();
 
+        // Keys typed ahead are handled without waiting; otherwise sleep until a key, a
+        // terminal resize or the next second on the round clock
         int ch = getch();
+        if (ch == ERR && waitForInput(roundClock.msUntilNextSecond()))
+            ch = getch();
+
+        // Let a burst of resizes settle and lay out once; a key ending the burst is kept
+        if (ch == KEY_RESIZE) {
+            while (waitForInput(RESIZE_SETTLE_MS)) {
+                int next = getch();
+                if (next != KEY_RESIZE && next != ERR) {
+                    ungetch(next);
+                    break;
+                }
+            }
+        }
 
-        // Handle Input
-        handleInput(ch);
+        // Handle every key that is waiting, then draw the result once
+        while (ch != ERR) {
+            handleInput(ch);
+            if (current_state == GameState::MAIN_MENU)
+                break;
+            ch = getch();
+        }
 
         // Check if state changed
         if (current_state == GameState::MAIN_MENU) {
@@ -1067,98 +656,169 @@ void Gameplay::run() {
             refresh();
             break;
         }
-        napms(30);
+
+        // Debug builds check that drawing a frame and handling a move never allocate
+        if (ALLOC_COUNTING) {
+            size_t shownAllocations = frameAllocations;
+            frameAllocations = allocationCount() - allocationsBefore;
+            if (frameAllocations != shownAllocations)
+                dirtyPanels |= TIME_PANEL;
+            if (steadyFrame && frameAllocations > 0 && allocatingFrames++ == 0)
+                emit(HistoryEvent::FRAME_ALLOCATED,
+                           historyValue(static_cast<long long>(frameAllocations)));
+        }
     }
 }
 
-// Display functions
-void Gameplay::displayMap() {
-    werase(mapWin);
-
-    // Get window dimensions
-    int maxY = getmaxy(mapWin);
-    int maxX = getmaxx(mapWin);
-
-    // Draw Map Content
-    for (int y = 0; y < map_size; ++y) {
-        for (int x = 0; x < map_size; ++x) {
-            int winY = y;
-            int winX = x * 2;
-            if (winY >= 0 && winY < maxY && winX >= 0 && winX < maxX - 1) {
-                char displayChar = mapGrid[y][x];
-                int colorPair = 0;
-
-                // Determine color based on character
-                if (displayChar == '.') {
-                    colorPair = 3;
-                } else if (displayChar == 'O') {
-                    // Find which package this is
-                    for (int i = 0; i < num_pkg; ++i) {
-                        if (packagePickUpLocs[i].first == y && packagePickUpLocs[i].second == x) {
-                            colorPair = 4 + i;  // Assign color pair
-                            break;
-                        }
-                    }
-                } else if (displayChar == 'X') {
-                    // Find which destination this is
-                    for (int i = 0; i < num_pkg; ++i) {
-                        if (packageDestLocs[i].first == y && packageDestLocs[i].second == x) {
-                            colorPair = 4 + i;  // Assign color pair
-                            break;
-                        }
-                    }
-                } else if (displayChar == '[' || displayChar == '$' || displayChar == ']') {
-                    // Check if it's part of any *active* supply station in the vector
-                    bool isPartOfActiveStation = false;
-                    for (const auto& stationLoc : supplyStationLocations) {
-                        if (y == stationLoc.first && x >= stationLoc.second &&
-                            x <= stationLoc.second + 2) {
-                            isPartOfActiveStation = true;
-                            break;
-                        }
-                    }
-                    if (isPartOfActiveStation) {
-                        colorPair = 9;  // Apply supply station color (Pair 9)
-                    }
-                    // If it's '[', '$', ']' but not in the active list, it gets default color (0)
-                } else if (displayChar == '~') {
-                    colorPair = 10;  // Speed bump color (Pair 10)
-                } else if (displayChar == 'Q') {
-                    // Optional: Add color for Exit 'Q' if desired (e.g., pair 9 or a new one)
-                    // colorPair = 9;
-                } else if (displayChar == '#' || displayChar == '-' || displayChar == '|' ||
-                           displayChar == '+') {
-                    // Optional: Add color for obstacles/borders if desired
-                }
+// Panels whose content an event can change; the history panel shows every event
+unsigned Gameplay::panelsChangedBy(HistoryEvent event) {
+    switch (event) {
+        case HistoryEvent::MOVED:
+        case HistoryEvent::MOVED_STEPS:
+        case HistoryEvent::SUPPLY_OPENED:
+            return HISTORY_PANEL | MAP_PANEL | STATS_PANEL | STAMINA_PANEL;
+        case HistoryEvent::PACKAGE_SELECTED:
+            return HISTORY_PANEL | PACKAGE_PANEL;
+        case HistoryEvent::PICKED_UP:
+        case HistoryEvent::DROPPED:
+        case HistoryEvent::DELIVERED:
+            return HISTORY_PANEL | MAP_PANEL | STATS_PANEL | PACKAGE_PANEL;
+        case HistoryEvent::LEVEL_COMPLETE:
+            return HISTORY_PANEL | STATS_PANEL | STAMINA_PANEL;
+        case HistoryEvent::NEXT_ROUND:
+            return HISTORY_PANEL | STATS_PANEL | LEGEND_PANEL;  // The round is the legend title
+        default:
+            return HISTORY_PANEL;
+    }
+}
 
-                // Apply color if specified
-                if (colorPair > 0) {
-                    wattron(mapWin, COLOR_PAIR(colorPair));
-                }
+// Map tiles an event changed, besides the player moving
+void Gameplay::markChangedCells(const HistoryRecord& record) {
+    int first = 0;
+    int count = 0;
+    switch (record.event) {
+        case HistoryEvent::PICKED_UP:
+        case HistoryEvent::DROPPED:
+        case HistoryEvent::DELIVERED:
+            first = core.grid.index(core.playerY, core.playerX);
+            count = 1;
+            break;
+        case HistoryEvent::SUPPLY_OPENED: {
+            const std::pair<int, int>& station = core.supplyStationLocations[record.values[3]];
+            first = core.grid.index(station.first, station.second);
+            count = 3;
+        } break;
+        default:
+            return;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (changedCellCount == static_cast<int>(sizeof(changedCells) / sizeof(changedCells[0])))
+            mapStale = true;
+        else
+            changedCells[changedCellCount++] = first + i;
+    }
+}
 
-                // Use mvwaddch for single characters
-                mvwaddch(mapWin, winY, winX, displayChar);
+// After anything that cleared or covered the screen
+void Gameplay::redrawAllPanels() {
+    dirtyPanels = ALL_PANELS;
+    mapStale = true;
+    changedCellCount = 0;
+}
 
-                // Turn off color
-                if (colorPair > 0) {
-                    wattroff(mapWin, COLOR_PAIR(colorPair));
-                }
-            }
-        }
+// Draw the dirty panels, returns how many were drawn
+int Gameplay::repaintPanels() {
+    int drawn = 0;
+    if (dirtyPanels & MAP_PANEL) {
+        displayMap();
+        drawn++;
+    }
+    if (dirtyPanels & STATS_PANEL) {
+        displayStats();
+        drawn++;
+    }
+    if (dirtyPanels & LEGEND_PANEL) {
+        displayLegend();
+        drawn++;
+    }
+    if (dirtyPanels & STAMINA_PANEL) {
+        displayStaminaBar();
+        drawn++;
+    }
+    if (dirtyPanels & HISTORY_PANEL) {
+        displayHistory();
+        drawn++;
+    }
+    if (dirtyPanels & PACKAGE_PANEL) {
+        displayPackages();
+        drawn++;
     }
 
-    // Draw Player (using color pair 2)
-    int playerWinY = playerY;
-    int playerWinX = playerX * 2;
-    if (playerWinY >= 0 && playerWinY < maxY && playerWinX >= 0 && playerWinX < maxX - 1) {
-        wattron(mapWin, COLOR_PAIR(2) | A_BOLD);
-        mvwaddch(mapWin, playerWinY, playerWinX, '@');
-        wattroff(mapWin, COLOR_PAIR(2) | A_BOLD);
+    // The time panel goes last since it shows the count: it is redrawn with any other panel,
+    // and on its own only when the displayed second changes
+    if (drawn > 0 || roundClock.elapsedSeconds() != shownSecond)
+        dirtyPanels |= TIME_PANEL;
+    if (dirtyPanels & TIME_PANEL) {
+        panelsRepainted = ++drawn;
+        displayTime();
+    }
+
+    dirtyPanels = 0;
+    return drawn;
+}
+
+// Display functions
+void Gameplay::displayMap() {
+    const int rows = std::min(core.grid.height(), getmaxy(mapWin));
+    const int rowLength = core.grid.width() * 2;
+    const int columns = std::min(rowLength, getmaxx(mapWin));
+
+    if (mapStale) {
+        // Compose every row, then write each with one call
+        werase(mapWin);
+        for (int y = 0; y < rows; ++y) {
+            composeMapRow(y);
+            mvwaddchnstr(mapWin, y, 0, &mapCells[y * rowLength], columns);
+        }
+        mapStale = false;
+    } else {
+        // The window still holds the last frame: put back the tile the player left and
+        // rewrite the tiles that changed
+        for (int i = 0; i < changedCellCount; ++i) {
+            int y = changedCells[i] / core.grid.width();
+            int x = changedCells[i] % core.grid.width();
+            chtype& cell = mapCells[y * rowLength + x * 2];
+            cell = mapCell(core.grid.at(y, x), core.grid.idAt(y, x));
+            if (y < rows && x * 2 < columns)
+                mvwaddch(mapWin, y, x * 2, cell);
+        }
+        if (drawnPlayerY < rows && drawnPlayerX * 2 < columns)
+            mvwaddch(mapWin, drawnPlayerY, drawnPlayerX * 2,
+                     mapCells[drawnPlayerY * rowLength + drawnPlayerX * 2]);
     }
+    changedCellCount = 0;
+
+    // Draw Player
+    if (core.playerY < rows && core.playerX * 2 < columns)
+        mvwaddch(mapWin, core.playerY, core.playerX * 2, PLAYER_CELL);
+    drawnPlayerY = core.playerY;
+    drawnPlayerX = core.playerX;
 
     wnoutrefresh(mapWin);
 }
 
+// Glyphs in the even screen columns, blanks between them
+void Gameplay::composeMapRow(int y) {
+    const int width = core.grid.width();
+    const Tile* tiles = core.grid.row(y);
+    const uint16_t* ids = core.grid.idRow(y);
+    chtype* cells = &mapCells[y * width * 2];
+    for (int x = 0; x < width; ++x) {
+        cells[2 * x] = mapCell(tiles[x], ids[x]);
+        cells[2 * x + 1] = ' ';
+    }
+}
+
 void Gameplay::displayStats() {
     werase(statsWin);
     box(statsWin, 0, 0);
@@ -1169,19 +829,19 @@ void Gameplay::displayStats() {
 
     // --- Display Total Score ---
     mvwprintw(statsWin, row++, col, "Total Score:");
-    mvwprintw(statsWin, row++, col, " %lld", totalScore);
+    mvwprintw(statsWin, row++, col, " %lld", core.totalScore);
 
     // --- Add space ---
     row++;
 
     // --- Display Last Round Score ---
-    if (roundNumber > 1) {  // Only show if at least one round is complete
+    if (core.roundNumber > 1) {  // Only show if at least one round is complete
         mvwprintw(statsWin, row++, col, "Last Round Score:");
-        int lastRoundScore = lastRoundStepScore + lastRoundTimeScore;
+        int lastRoundScore = core.lastRoundStepScore + core.lastRoundTimeScore;
         mvwprintw(statsWin, row++, col, " %d", lastRoundScore);
         // Show breakdown
-        mvwprintw(statsWin, row++, col, " (Steps:%d + Time:%d)", lastRoundStepScore,
-                  lastRoundTimeScore);
+        mvwprintw(statsWin, row++, col, " (Steps:%d + Time:%d)", core.lastRoundStepScore,
+                  core.lastRoundTimeScore);
     } else {
         mvwprintw(statsWin, row++, col, "Last Round Score:");
         mvwprintw(statsWin, row++, col, " N/A");
@@ -1193,14 +853,23 @@ void Gameplay::displayStats() {
 
     // --- Display Packages Delivered (Current Round) ---
     mvwprintw(statsWin, row++, col, "Packages Delivered:");
-    mvwprintw(statsWin, row++, col, " %d / %d", packagesDelivered, num_pkg);
+    mvwprintw(statsWin, row++, col, " %d / %d", core.packagesDelivered, core.numPackages);
 
     // --- Add space ---
     row++;
 
     // --- Display Steps Taken (Current Round) ---
     mvwprintw(statsWin, row++, col, "Steps This Round:");
-    mvwprintw(statsWin, row++, col, " %d", stepsTakenThisRound);
+    mvwprintw(statsWin, row++, col, " %d", core.stepsThisRound);
+
+    // --- Add space ---
+    row++;
+
+    // --- Display Session Totals (counted from the event stream) ---
+    mvwprintw(statsWin, row++, col, "This Session:");
+    mvwprintw(statsWin, row++, col, " Moves: %d", tally.steps());
+    mvwprintw(statsWin, row++, col, " Delivered: %d", tally.count(HistoryEvent::DELIVERED));
+    mvwprintw(statsWin, row++, col, " Supplies: %d", tally.count(HistoryEvent::SUPPLY_OPENED));
 
     wnoutrefresh(statsWin);
 }
@@ -1211,22 +880,24 @@ void Gameplay::displayTime() {
     mvwprintw(timeWin, 0, 2, " Time Info ");
 
     // --- Calculate Elapsed Time ---
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - startTime);
-    long long totalSeconds = elapsed.count();
+    long long totalSeconds = roundClock.elapsedSeconds();
+    shownSecond = totalSeconds;
     int minutes = totalSeconds / 60;
     int seconds = totalSeconds % 60;
 
-    // --- Format Time String (MM:SS) ---
-    std::ostringstream timeStream;
-    timeStream << std::setw(2) << std::setfill('0') << minutes << ":" << std::setw(2)
-               << std::setfill('0') << seconds;
-    std::string timeStr = timeStream.str();
-
-    // --- Display Information ---
+    // --- Display Information (MM:SS) ---
     int row = 2;
     int col = 2;
-    mvwprintw(timeWin, row++, col, "Elapsed: %s", timeStr.c_str());
+    mvwprintw(timeWin, row++, col, "Elapsed: %02d:%02d", minutes, seconds);
+    mvwprintw(timeWin, row++, col, "Redrawn: %d/%d panels", panelsRepainted, PANEL_COUNT);
+
+    if (ALLOC_COUNTING) {
+        mvwprintw(timeWin, row++, col, "Allocs/frame: %zu", frameAllocations);
+        if (allocatingFrames > 0)
+            wattron(timeWin, A_REVERSE);
+        mvwprintw(timeWin, row++, col, "Alloc frames: %d", allocatingFrames);
+        wattroff(timeWin, A_REVERSE);
+    }
     wnoutrefresh(timeWin);
 }
 
@@ -1238,72 +909,20 @@ void Gameplay::displayLegend() {
     int winHeight = getmaxy(legendWin);
 
     // Display Round Number
-    std::string roundText = "Round " + std::to_string(roundNumber);
+    char roundText[32];
+    int roundLength = std::snprintf(roundText, sizeof(roundText), "Round %d", core.roundNumber);
     wattron(legendWin, A_BOLD);
     // Ensure title doesn't overwrite corners if window is very narrow
-    int titleX = std::max(1, (getmaxx(legendWin) - static_cast<int>(roundText.length()) - 2) / 2);
-    mvwprintw(legendWin, 0, titleX, " %s ", roundText.c_str());
+    int titleX = std::max(1, (getmaxx(legendWin) - roundLength - 2) / 2);
+    mvwprintw(legendWin, 0, titleX, " %s ", roundText);
     wattroff(legendWin, A_BOLD);
 
-    // --- Starting row for content ---
-    int row = 2;  // Start below top border and title line
-    int col = 2;
-    int lastAvailableRow = winHeight - 2;  // Last usable row before bottom border
-
     // --- Legend Content ---
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "--- Legend ---");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " @: Player");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " #: Obstacle");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " ~: Speed Bump");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " [$]: Supply Station");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " O: Package");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " X: Destination");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " Q: Exit");
-    if (row <= lastAvailableRow)
-        row++;  // Blank line
-
-    // --- Movement Controls ---
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "--- Movement ---");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   W: Move Up");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   S: Move Down");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   A: Move Left");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   D: Move Right");
-    if (row <= lastAvailableRow)
-        row++;  // Blank line
-
-    // --- Package Controls ---
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "--- Package ---");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   Q: Pick Up");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "   E: Drop current");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " 1-5: Select package");
-    if (row <= lastAvailableRow)
-        row++;  // Blank line
-
-    // --- Game Controls ---
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, "---- Game ----");
-    // Combine Enter description
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " Enter: Next Level (at Q)");
-    if (row <= lastAvailableRow)
-        mvwprintw(legendWin, row++, col, " ESC: Exit to Menu");
+    // Copied from the pad below the title line, clipped to the borders
+    int lastRow = std::min(1 + LEGEND_LINE_COUNT, winHeight - 2);
+    int lastCol = std::min(1 + getmaxx(legendPad), getmaxx(legendWin) - 2);
+    if (lastRow >= 2 && lastCol >= 2)
+        copywin(legendPad, legendWin, 0, 0, 2, 2, lastRow, lastCol, FALSE);
 
     wnoutrefresh(legendWin);
 }
@@ -1319,10 +938,10 @@ void Gameplay::displayStaminaBar() {
     // --- Bar Calculation ---
     int barWidth = getmaxx(staminaWin) - 4;
     int numFilled = 0;
-    if (maxStamina > 0) {
+    if (core.maxStamina > 0) {
         if (barWidth > 0) {
             numFilled = static_cast<int>(
-                std::floor(static_cast<double>(currentStamina) / maxStamina * barWidth));
+                std::floor(static_cast<double>(core.stamina) / core.maxStamina * barWidth));
             numFilled = std::max(0, std::min(barWidth, numFilled));
         }
     } else {
@@ -1338,10 +957,12 @@ void Gameplay::displayStaminaBar() {
     wattroff(staminaWin, COLOR_PAIR(1));
 
     // --- Numerical Display ---
-    std::string staminaText = std::to_string(currentStamina) + " / " + std::to_string(maxStamina);
-    int textX = getmaxx(staminaWin) - 2 - staminaText.length();
+    char staminaText[32];
+    int textLength =
+        std::snprintf(staminaText, sizeof(staminaText), "%d / %d", core.stamina, core.maxStamina);
+    int textX = getmaxx(staminaWin) - 2 - textLength;
     textX = std::max(2, textX);  // Ensure it doesn't overwrite left border
-    mvwprintw(staminaWin, 1, textX, "%s", staminaText.c_str());
+    mvwprintw(staminaWin, 1, textX, "%s", staminaText);
 
     wnoutrefresh(staminaWin);
 }
@@ -1351,30 +972,41 @@ void Gameplay::displayHistory() {
     box(historyWin, 0, 0);
 
     // --- Title ---
-    const char* title = " Gameplay History ";
-    mvwprintw(historyWin, 0, 2, "%s", title);
+    if (historyNoMatch)
+        mvwprintw(historyWin, 0, 2, " History: no match for \"%s\" ", historyQuery);
+    else if (historyScroll > 0)
+        mvwprintw(historyWin, 0, 2, " Gameplay History (-%d) ", historyScroll);
+    else
+        mvwprintw(historyWin, 0, 2, " Gameplay History ");
 
     // --- Display Messages ---
-    int maxLines = getmaxy(historyWin) - 2;
-    int startIdx = 0;
-    if (historyMessages.size() > maxLines) {
-        startIdx = historyMessages.size() - maxLines;
-    }
-
+    // Only the records on screen are fetched (from the ring, or the log when scrolled far
+    // back) and formatted
+    int maxLines = std::max(0, getmaxy(historyWin) - 2);
+    int64_t last = history.size() - historyScroll;
+    int64_t first = std::max(history.oldest(), last - maxLines);
+
+    // Truncate messages that are too long for the window width
+    int maxWidth = std::max(0, getmaxx(historyWin) - 4);
     int currentLine = 1;  // Start drawing from line 1
-    for (size_t i = startIdx; i < historyMessages.size(); ++i) {
-        // Truncate message if too long for window width
-        int maxWidth = getmaxx(historyWin) - 4;
-        maxWidth = std::max(0, maxWidth);  // Ensure maxWidth is not negative
-        std::string msg = historyMessages[i];
-        if (msg.length() > maxWidth) {
-            msg.resize(maxWidth);
+    HistoryRecord records[64];
+    char line[HISTORY_LINE_LENGTH];
+    for (int64_t i = first; i < last;) {
+        int n = history.read(i, static_cast<int>(std::min<int64_t>(64, last - i)), records);
+        if (n == 0)
+            break;
+        for (int k = 0; k < n; ++k) {
+            formatHistoryRecord(records[k], line, sizeof(line));
+            attr_t attr = (i + k == historyMatch) ? A_REVERSE : A_NORMAL;
+            wattron(historyWin, attr);
+            mvwaddnstr(historyWin, currentLine++, 2, line, maxWidth);
+            wattroff(historyWin, attr);
         }
-        mvwprintw(historyWin, currentLine++, 2, "%s", msg.c_str());
+        i += n;
     }
 
     // Example placeholder if no messages yet
-    if (historyMessages.empty() && maxLines > 0) {
+    if (last == 0 && maxLines > 0) {
         mvwprintw(historyWin, 1, 2, "No events yet...");
     }
 
@@ -1386,123 +1018,101 @@ void Gameplay::displayPackages() {
     box(packageWin, 0, 0);
 
     // --- Title ---
-    const char* title = " Packages ";
-    mvwprintw(packageWin, 0, 2, "%s", title);
+    mvwprintw(packageWin, 0, 2, " Packages (%d held) ", heldCount(core));
 
     // --- Package Slot Display ---
-    const char* emptySlot = "_";
-
-    const char* packageChars[] = {"1", "2", "3", "4", "5"};
+    // A held package shows its number, an empty slot '_'. When the slots do not fit, the row
+    // scrolls to keep the selected package in view and '<' / '>' mark the hidden ones.
+    const int slotWidth = decimalDigits(core.numPackages) + 1;
+    const int innerWidth = std::max(0, getmaxx(packageWin) - 4);
+    int visibleSlots = std::max(1, innerWidth / slotWidth);
+    if (visibleSlots < core.numPackages)
+        visibleSlots = std::max(1, (innerWidth - 4) / slotWidth);  // Leave room for the markers
+
+    if (core.currentPackageIndex >= 0) {
+        if (core.currentPackageIndex < packageScroll)
+            packageScroll = core.currentPackageIndex;
+        else if (core.currentPackageIndex >= packageScroll + visibleSlots)
+            packageScroll = core.currentPackageIndex - visibleSlots + 1;
+    }
+    packageScroll = std::max(0, std::min(packageScroll, core.numPackages - visibleSlots));
 
-    int startX = 2;
-    int currentX = startX;
     int yPos = 1;
+    int currentX = 2;
+    bool scrolls = visibleSlots < core.numPackages;
+    if (scrolls) {
+        mvwaddstr(packageWin, yPos, currentX, packageScroll > 0 ? "<" : " ");
+        currentX += 2;
+    }
 
-    for (int i = 0; i < num_pkg; ++i) {
-        const char* displayChar = emptySlot;
-        int colorPair = 0;
-
-        if (hasPackage[i]) {
-            if (i < 5) {
-                displayChar = packageChars[i];
-            } else {
-                displayChar = "?";  // Fallback if more than 5 packages somehow
-            }
-            colorPair = 4 + i;
-        }
-
-        // Check for highlight (selected package)
-        bool isHighlighted = (i == currentPackageIndex);
-        if (isHighlighted) {
-            wattron(packageWin, A_REVERSE);
-        }
-
-        // Apply color if holding the package
-        if (colorPair > 0) {
-            wattron(packageWin, COLOR_PAIR(colorPair));
-        }
-
-        // Print the character - mvwaddstr works for both single-byte and multi-byte chars
-        mvwaddstr(packageWin, yPos, currentX, displayChar);
+    int lastSlot = std::min(core.numPackages, packageScroll + visibleSlots);
+    for (int i = packageScroll; i < lastSlot; ++i) {
+        bool held = isHeld(core, i);
+        char label[12] = "_";  // Fits any int
+        if (held)
+            std::snprintf(label, sizeof(label), "%d", i + 1);
 
-        // Turn off color if it was applied
-        if (colorPair > 0) {
-            wattroff(packageWin, COLOR_PAIR(colorPair));
-        }
+        // Highlight the selected package, color the held ones
+        attr_t attr = held ? packageColor(i) : A_NORMAL;
+        if (i == core.currentPackageIndex)
+            attr |= A_REVERSE;
 
-        // Turn off highlight if it was on
-        if (isHighlighted) {
-            wattroff(packageWin, A_REVERSE);
-        }
+        wattron(packageWin, attr);
+        mvwaddstr(packageWin, yPos, currentX, label);
+        wattroff(packageWin, attr);
 
-        // Add spacing (adjust as needed for character width)
-        // Using 2 columns spacing should work reasonably for both cases
-        currentX += 2;
+        currentX += slotWidth;
     }
 
+    if (scrolls && lastSlot < core.numPackages)
+        mvwaddstr(packageWin, yPos, currentX, ">");
+
     wnoutrefresh(packageWin);
 }
 
-// Function to add a message to the history
-// This function can be called from anywhere in the Gameplay class
-void Gameplay::addHistoryMessage(const std::string& message) {
-    historyMessages.push_back(message);
+// Every change of play goes through here: the event is applied to the state, then kept in
+// the history and the session tally
+void Gameplay::emit(HistoryEvent event, int a, int b, int c, int d) {
+    const HistoryRecord record = {event, {a, b, c, d}};
+    applyEvent(core, record);
+    history.add(record);
+    tally.record(record);
+    dirtyPanels |= panelsChangedBy(event);
+    markChangedCells(record);
+    if (historyScroll > 0)
+        historyScroll++;  // Keep a scrolled back view where it is
 }
 
-// Check if distance between packages generated are too close
-bool Gameplay::invalidPackageDistance(const int& y, const int& x, const int& i) {
-    int minDistance;
-    switch (difficultyHighlight) {
-        case 0:               // Easy
-            minDistance = 6;  // Map will fail to generate if set too high
-            break;
-        case 1:  // Medium
-            minDistance = 7;
-            break;
-        case 2:  // Hard
-            minDistance = 8;
-            break;
-        default:
-            minDistance = 6;
-            break;
-    }
-
-    int y1 = y;
-    int x1 = x;
-    int y2 = packagePickUpLocs[i].first;
-    int x2 = packagePickUpLocs[i].second;
-    int currentDistance = std::sqrt(std::pow(x2 - x1, 2) + std::pow(y2 - y1, 2));
-
-    return currentDistance < minDistance;
+// Positive counts go back in time; clamped to the records that can still be read
+void Gameplay::scrollHistory(int records) {
+    int64_t readable = history.size() - history.oldest();
+    int64_t scroll = static_cast<int64_t>(historyScroll) + records;
+    scroll = std::min(scroll, readable - 1);
+    historyScroll = static_cast<int>(std::max<int64_t>(0, scroll));
+    historyNoMatch = false;
+    dirtyPanels |= HISTORY_PANEL;
 }
 
-// Check if distance between individual packages and destinations is too close
-bool Gameplay::invalidDestinationDistance(const int& y, const int& x,
-                                          const int& destinationsPlaced) {
-    int minDistance;
-    switch (difficultyHighlight) {
-        case 0:  // Easy
-            minDistance = 8;
-            break;
-        case 1:  // Medium
-            minDistance = 9;
-            break;
-        case 2:  // Hard
-            minDistance = 10;
-            break;
-        default:
-            minDistance = 8;
-            break;
+// Find the newest record older than the previous match (or the bottom of the view) that
+// contains the query and scroll it to the bottom line. The prompt keeps the last query, so
+// Enter alone searches further back.
+void Gameplay::searchHistory() {
+    if (!promptText(" Search History ", "Find: ", historyQuery,
+                    static_cast<int>(sizeof(historyQuery)) - 1, false) ||
+        historyQuery[0] == '\0')
+        return;
+
+    int64_t size = history.size();
+    int64_t before = size - historyScroll;
+    if (historyMatch >= 0 && historyMatch < before)
+        before = historyMatch;
+    int64_t found = history.findBackward(historyQuery, before);
+    historyNoMatch = (found < 0);
+    dirtyPanels |= HISTORY_PANEL;
+    if (found >= 0) {
+        historyMatch = found;
+        historyScroll = static_cast<int>(size - 1 - found);
     }
-
-    int y1 = y;
-    int x1 = x;
-    int y2 = packagePickUpLocs[destinationsPlaced].first;
-    int x2 = packagePickUpLocs[destinationsPlaced].second;
-
-    int currentDistance = std::sqrt(std::pow(x2 - x1, 2) + std::pow(y2 - y1, 2));
-
-    return currentDistance < minDistance;
 }
 
 void Gameplay::displayPopupMessage(const std::string& title,
@@ -1575,12 +1185,17 @@ void Gameplay::displayPopupMessage(const std::string& title,
     nodelay(popupWin, FALSE);  // Force blocking mode for popup
     wtimeout(popupWin, -1);    // Make sure it waits for input
 
-    wgetch(popupWin);
+    {
+        ClockPause pause(roundClock);  // Reading the popup is not playing time
+        wgetch(popupWin);
+    }
     delwin(popupWin);
 
     // Touch the main screen and refresh to redraw the underlying game state cleanly
     touchwin(stdscr);
     refresh();
+    steadyFrame = false;
+    redrawAllPanels();
 }
 
 bool Gameplay::displayQuitOptions() {
@@ -1610,8 +1225,8 @@ bool Gameplay::displayQuitOptions() {
     keypad(popupWin, TRUE);
     box(popupWin, 0, 0);
 
-    // Record time when the pause started
-    auto pauseStartTime = std::chrono::steady_clock::now();
+    // The round clock stops while the dialog is open
+    ClockPause pause(roundClock);
 
     // --- Display Title (Centered) ---
     int titleX = (popupWidth - static_cast<int>(title.length())) / 2;
@@ -1678,33 +1293,96 @@ bool Gameplay::displayQuitOptions() {
     nodelay(popupWin, TRUE);  // Restore non-blocking
     delwin(popupWin);
 
-    // Adjust the startTime by the duration spent in this dialog
-    auto pauseEndTime = std::chrono::steady_clock::now();
-    auto pauseDuration = pauseEndTime - pauseStartTime;
-    startTime += pauseDuration;
-
     // Redraw the screen
     touchwin(stdscr);
     refresh();
+    steadyFrame = false;
+    redrawAllPanels();
 
     return selectedYes;
 }
 
+// Ask for a package number; returns 0 if the prompt was cancelled
+int Gameplay::promptPackageNumber() {
+    char label[32];
+    std::snprintf(label, sizeof(label), "Package (1-%d): ", core.numPackages);
+    char digits[8] = "";
+    if (!promptText(" Select Package ", label, digits, decimalDigits(core.numPackages), true) ||
+        digits[0] == '\0')
+        return 0;
+    return std::atoi(digits);
+}
+
+// One-line text prompt. `text` (maxLength chars plus the terminator) holds the initial text and
+// receives the answer; returns false if the prompt was cancelled.
+bool Gameplay::promptText(const char* title, const char* label, char* text, int maxLength,
+                          bool digitsOnly) {
+    int popupHeight = 5;
+    int popupWidth = std::max(30, static_cast<int>(std::strlen(label)) + maxLength + 8);
+    popupWidth = std::min(popupWidth, std::max(1, width));
+    int popupY = (height - popupHeight) / 2;
+    int popupX = (width - popupWidth) / 2;
+
+    WINDOW* popupWin = newwin(popupHeight, popupWidth, popupY, popupX);
+    keypad(popupWin, TRUE);
+
+    // The clock does not run while the prompt is open
+    ClockPause pause(roundClock);
+
+    int length = static_cast<int>(std::strlen(text));
+    bool done = false;
+    bool cancelled = false;
+    while (!done) {
+        werase(popupWin);
+        box(popupWin, 0, 0);
+        mvwprintw(popupWin, 0, 2, "%s", title);
+        mvwprintw(popupWin, 2, 3, "%s%s", label, text);
+        wrefresh(popupWin);
+
+        int ch = wgetch(popupWin);
+        bool accepted = digitsOnly ? (ch >= '0' && ch <= '9') : (ch >= 32 && ch < 127);
+        if (accepted) {
+            if (length < maxLength) {
+                text[length++] = static_cast<char>(ch);
+                text[length] = '\0';
+            }
+        } else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b') {
+            if (length > 0)
+                text[--length] = '\0';
+        } else if (ch == '\n' || ch == KEY_ENTER) {
+            done = true;
+        } else if (ch == 27) {  // ESC
+            cancelled = true;
+            done = true;
+        }
+    }
+
+    delwin(popupWin);
+
+    // Redraw the screen
+    touchwin(stdscr);
+    refresh();
+    steadyFrame = false;
+    redrawAllPanels();
+
+    return !cancelled;
+}
+
 void Gameplay::saveGameState() {
     std::ofstream saveFile("savegame.txt");
     if (saveFile.is_open()) {
         // Save essential game variables
         saveFile << difficultyHighlight << std::endl;
-        saveFile << roundNumber << std::endl;
-        saveFile << totalScore << std::endl;
-        saveFile << lastRoundStepScore << std::endl;
-        saveFile << lastRoundTimeScore << std::endl;
-        saveFile << currentStamina << std::endl;
-        saveFile << maxStamina << std::endl;
+        saveFile << core.roundNumber << std::endl;
+        saveFile << core.totalScore << std::endl;
+        saveFile << core.lastRoundStepScore << std::endl;
+        saveFile << core.lastRoundTimeScore << std::endl;
+        saveFile << core.stamina << std::endl;
+        saveFile << core.maxStamina << std::endl;
         saveFile.close();
-        addHistoryMessage("Game saved successfully.");
+        emit(HistoryEvent::GAME_SAVED);
     } else {
-        addHistoryMessage("Failed to save game.");
+        emit(HistoryEvent::SAVE_FAILED);
     }
 }
 
@@ -1715,58 +1393,28 @@ void Gameplay::loadGameState() {
         saveFile >> savedDifficulty;
 
         // Only load if difficulty matches or set proper difficulty
-        difficultyHighlight = savedDifficulty;
-
-        saveFile >> roundNumber;
-        saveFile >> totalScore;
-        saveFile >> lastRoundStepScore;
-        saveFile >> lastRoundTimeScore;
-        saveFile >> currentStamina;
-        saveFile >> maxStamina;
-
-        staminaAtRoundStart = currentStamina;
+        difficultyHighlight = (savedDifficulty >= 0 && savedDifficulty < NUM_DIFFICULTIES)
+                                  ? savedDifficulty
+                                  : 0;
+
+        saveFile >> core.roundNumber;
+        saveFile >> core.totalScore;
+        saveFile >> core.lastRoundStepScore;
+        saveFile >> core.lastRoundTimeScore;
+        saveFile >> core.stamina;
+        saveFile >> core.maxStamina;
+
+        core.staminaAtRoundStart = core.stamina;
         saveFile.close();
 
-        // Update difficulty-dependent settings
-        switch (difficultyHighlight) {
-            case 0:
-                diff_str = "Easy";
-                map_size = 15;  // Adjust in future
-                num_obs = 5;
-                num_pkg = 3;
-                break;
-            case 1:  // Medium
-                diff_str = "Medium";
-                map_size = 20;  // Same above
-                num_obs = 6;
-                num_pkg = 4;
-                break;
-            case 2:  // Hard
-                diff_str = "Hard";
-                map_size = 25;
-                num_obs = 7;
-                num_pkg = 5;
-                break;
-            default:
-                diff_str = "Unknown";
-                map_size = 15;
-                num_obs = 5;
-                num_pkg = 3;
-                break;
-        }
+        // The table's stamina cap wins over the saved one, older saves could lack it
+        updateDifficultyVariables();
 
-        addHistoryMessage("Game loaded successfully.");
-        addHistoryMessage("Continuing from Round " + std::to_string(roundNumber));
+        emit(HistoryEvent::GAME_LOADED);
+        emit(HistoryEvent::CONTINUING_ROUND, core.roundNumber);
     } else {
         // If loading fails, start a new game
-        addHistoryMessage("No saved game found. Starting new game.");
-        roundNumber = 1;
-        currentStamina = 200;
-        maxStamina = 200;
-        staminaAtRoundStart = 200;
-        totalScore = 0;
-        lastRoundStepScore = 0;
-        lastRoundTimeScore = 0;
-        updateDifficultyVariables();
+        emit(HistoryEvent::NO_SAVE);
+        startNewGame();
     }
 }
\ No newline at end of file
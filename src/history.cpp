@@ -0,0 +1,224 @@
+#include "../include/history.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// printf formats by event; every format is given all four values and uses what it needs
+constexpr const char* HISTORY_FORMATS[] = {
+    "Game Started. Round %d",
+    "Daily challenge: same maps for everyone today",
+    "No such package on this level.",
+    "Selected package %d.",
+    "Level Complete! +%d stamina bonus. Round Score: %d",
+    "Proceeding to Round %d...",
+    "Cannot exit yet! Deliver all packages first. (%d/%d delivered)",
+    "Not holding any packages.",
+    "No package to pick up here.",
+    "Error: Package 'O' found but no matching location data.",
+    "Picked up package %d.",
+    "Already holding package %d.",
+    "Cannot drop packages at the exit 'Q'.",
+    "Dropped package %d.",
+    "Delivered package %d!",
+    "Cannot drop package here. Location occupied.",
+    "No package selected/held to drop.",
+    "Exiting to main menu...",
+    "Continuing game...",
+    "Terminal resized.",
+    "Moved. Cost: %d. Stamina: %d -> %d",
+    "Moved %d steps. Stamina: %d -> %d",
+    "Supply opened! +%d stamina. (%d->%d)",
+    "Stepped on a speed bump! Next move costs double.",
+    "GAME OVER! You ran out of stamina. Final Score: %d",
+    "Cannot move! Need %d stamina, have %d.",
+    "GAME OVER! Stuck with no possible moves. Final Score: %d",
+    "Cannot move! Blocked by obstacle.",
+    "Cannot move! Hit the border.",
+    "Game saved successfully.",
+    "Failed to save game.",
+    "Game loaded successfully.",
+    "Continuing from Round %d",
+    "No saved game found. Starting new game.",
+    "Debug: a frame made %d heap allocations",
+};
+static_assert(sizeof(HISTORY_FORMATS) / sizeof(HISTORY_FORMATS[0]) ==
+                  static_cast<size_t>(HistoryEvent::COUNT),
+              "Every history event needs a format");
+
+// Case-insensitive strstr
+bool containsText(const char* haystack, const char* needle) {
+    for (; *haystack; ++haystack) {
+        const char* h = haystack;
+        const char* n = needle;
+        while (*n && std::tolower(static_cast<unsigned char>(*h)) ==
+                         std::tolower(static_cast<unsigned char>(*n))) {
+            ++h;
+            ++n;
+        }
+        if (!*n)
+            return true;
+    }
+    return !*needle;
+}
+
+}  // namespace
+
+int formatHistoryRecord(const HistoryRecord& record, char* out, size_t size) {
+    size_t event = static_cast<size_t>(record.event);
+    if (event >= static_cast<size_t>(HistoryEvent::COUNT))
+        return std::snprintf(out, size, "?");
+    int length = std::snprintf(out, size, HISTORY_FORMATS[event], record.values[0],
+                               record.values[1], record.values[2], record.values[3]);
+    return std::min(length, static_cast<int>(size) - 1);
+}
+
+GameHistory::GameHistory(const std::string& logPath)
+    : logPath(logPath),
+      logWriter(nullptr),
+      logReader(nullptr),
+      ring(RING_CAPACITY),
+      batch(WRITE_BATCH),
+      count(0),
+      written(0),
+      stopping(false) {
+    logWriter = std::fopen(logPath.c_str(), "wb");
+    if (logWriter)
+        logReader = std::fopen(logPath.c_str(), "rb");
+    if (!logReader) {
+        if (logWriter)
+            std::fclose(logWriter);
+        logWriter = nullptr;
+        return;
+    }
+    writer = std::thread(&GameHistory::writerLoop, this);
+}
+
+GameHistory::~GameHistory() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pending.notify_one();
+        writer.join();
+    }
+    if (logWriter)
+        std::fclose(logWriter);
+    if (logReader) {
+        std::fclose(logReader);
+        std::remove(logPath.c_str());
+    }
+}
+
+void GameHistory::add(const HistoryRecord& record) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (logWriter) {
+            // Records are only overwritten once they are in the log
+            spaceFreed.wait(lock, [this] { return count - written < RING_CAPACITY; });
+        }
+        ring[count % RING_CAPACITY] = record;
+        count++;
+        if (!logWriter)
+            written = count;
+    }
+    pending.notify_one();
+}
+
+int64_t GameHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+int64_t GameHistory::oldest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return logWriter ? 0 : std::max<int64_t>(0, count - RING_CAPACITY);
+}
+
+int GameHistory::read(int64_t first, int n, HistoryRecord* out) {
+    std::unique_lock<std::mutex> lock(mutex);
+    int64_t ringStart = std::max<int64_t>(0, count - RING_CAPACITY);
+    if (first < 0 || (!logWriter && first < ringStart))
+        return 0;
+    n = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(n, count - first)));
+
+    // The ring part is copied first: the writer may overwrite it once the lock is released
+    int fromLog = static_cast<int>(std::min<int64_t>(n, std::max<int64_t>(0, ringStart - first)));
+    for (int i = fromLog; i < n; ++i) {
+        out[i] = ring[(first + i) % RING_CAPACITY];
+    }
+    lock.unlock();
+
+    if (fromLog > 0 && readLog(first, fromLog, out) < fromLog)
+        return 0;
+    return n;
+}
+
+int64_t GameHistory::findBackward(const char* text, int64_t before) {
+    HistoryRecord chunk[64];
+    char line[HISTORY_LINE_LENGTH];
+    before = std::min(before, size());
+    const int64_t start = oldest();
+    while (before > start) {
+        int64_t first = std::max(start, before - 64);
+        int n = read(first, static_cast<int>(before - first), chunk);
+        if (n == 0)
+            return -1;
+        for (int i = n - 1; i >= 0; --i) {
+            formatHistoryRecord(chunk[i], line, sizeof(line));
+            if (containsText(line, text))
+                return first + i;
+        }
+        before = first;
+    }
+    return -1;
+}
+
+int GameHistory::readLog(int64_t first, int n, HistoryRecord* out) {
+    // Only records the writer has flushed are read, and those never change
+    std::clearerr(logReader);
+    if (std::fseek(logReader, static_cast<long>(first * sizeof(HistoryRecord)), SEEK_SET) != 0)
+        return 0;
+    return static_cast<int>(std::fread(out, sizeof(HistoryRecord), n, logReader));
+}
+
+void GameHistory::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        pending.wait(lock, [this] { return stopping || written < count; });
+        if (written == count)
+            return;  // Stopping with everything written
+
+        // Copy a batch out of the ring and write it without holding the lock
+        int64_t first = written;
+        int n = static_cast<int>(std::min<int64_t>(count - written, WRITE_BATCH));
+        for (int i = 0; i < n; ++i) {
+            batch[i] = ring[(first + i) % RING_CAPACITY];
+        }
+        lock.unlock();
+        bool logged = std::fwrite(batch.data(), sizeof(HistoryRecord), n, logWriter) ==
+                          static_cast<size_t>(n) &&
+                      std::fflush(logWriter) == 0;
+        lock.lock();
+
+        if (!logged) {
+            // Disk full or similar: go on with the ring alone, as if the log had never opened
+            std::fclose(logWriter);
+            logWriter = nullptr;
+            written = count;
+            spaceFreed.notify_all();
+            return;
+        }
+        written = first + n;
+        spaceFreed.notify_all();
+    }
+}
@@ -0,0 +1,78 @@
+#include "../include/input.h"
+
+#ifdef _WIN32
+
+#include <ncurses.h>
+
+#include <algorithm>
+
+// No poll() on the Windows console: fall back to short sleeps
+void installResizeWakeup() {}
+
+bool waitForInput(int timeoutMs) {
+    napms(timeoutMs < 0 ? 30 : std::min(timeoutMs, 30));
+    return true;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace {
+
+// Self-pipe: the signal handler writes a byte so a resize can never slip in between
+// checking for one and going to sleep
+int wakeupPipe[2] = {-1, -1};
+struct sigaction previousHandler;
+
+void onResize(int signal, siginfo_t* info, void* context) {
+    int savedErrno = errno;
+    char byte = 0;
+    if (write(wakeupPipe[1], &byte, 1) < 0) {
+        // The pipe is full, so a wakeup is already pending
+    }
+    errno = savedErrno;
+
+    // Let ncurses see the resize as well
+    if (previousHandler.sa_flags & SA_SIGINFO) {
+        previousHandler.sa_sigaction(signal, info, context);
+    } else if (previousHandler.sa_handler != SIG_DFL && previousHandler.sa_handler != SIG_IGN) {
+        previousHandler.sa_handler(signal);
+    }
+}
+
+}  // namespace
+
+void installResizeWakeup() {
+    if (wakeupPipe[0] >= 0 || pipe(wakeupPipe) != 0)
+        return;
+    for (int fd : wakeupPipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    struct sigaction action;
+    action.sa_sigaction = onResize;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGWINCH, &action, &previousHandler);
+}
+
+bool waitForInput(int timeoutMs) {
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wakeupPipe[0], POLLIN, 0}};
+    int ready = poll(fds, wakeupPipe[0] >= 0 ? 2 : 1, timeoutMs);
+    if (ready < 0)
+        return errno == EINTR;  // Interrupted by a signal, most likely the resize itself
+    if (ready > 0 && (fds[1].revents & POLLIN)) {
+        char drain[64];
+        while (read(wakeupPipe[0], drain, sizeof(drain)) > 0) {
+        }
+    }
+    return ready > 0;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "../include/layout.h"
+
+#include <algorithm>
+
+namespace {
+
+const int BOTTOM_PANEL_HEIGHT = 3;  // Common height for stamina and package
+const int MIN_SIDE_PANEL_WIDTH = 20;
+const int MIN_LEGEND_HEIGHT = 30;
+
+}  // namespace
+
+GameLayout computeLayout(int height, int width, int mapSize, int packageRowWidth) {
+    GameLayout layout;
+
+    // --- Bottom Bar ---
+    int staminaWidth = std::max(20, width / 3);
+    // One slot per package up to half the screen (it scrolls)
+    int packageWidth = 4 + packageRowWidth + 4;
+    packageWidth = std::max(15, std::min(packageWidth, width / 2));
+
+    // Adjust widths if total exceeds screen width
+    int totalBottomWidth = staminaWidth + packageWidth;
+    if (totalBottomWidth > width) {
+        double ratio = static_cast<double>(width) / totalBottomWidth;
+        staminaWidth = std::max(10, static_cast<int>(staminaWidth * ratio));
+        packageWidth = std::max(1, width - staminaWidth);  // Give remaining space to package
+    }
+    staminaWidth = std::max(1, staminaWidth);
+
+    // Centered as a pair
+    int bottomY = std::max(0, height - BOTTOM_PANEL_HEIGHT);
+    int bottomStartX = std::max(0, (width - (staminaWidth + packageWidth)) / 2);
+    layout.stamina = {bottomY, bottomStartX, BOTTOM_PANEL_HEIGHT, staminaWidth};
+    layout.package = {bottomY, bottomStartX + staminaWidth, BOTTOM_PANEL_HEIGHT, packageWidth};
+
+    // --- Side Panel Width ---
+    // A quarter of the screen each, less if the map would not fit between them
+    int mapWidth = mapSize * 2;
+    int sideWidth = std::min(width / 4, (width - mapWidth) / 2);
+    sideWidth = std::max(std::min(MIN_SIDE_PANEL_WIDTH, width / 4), sideWidth);
+
+    // --- Left Column: Legend over History ---
+    int columnHeight = std::max(1, height - BOTTOM_PANEL_HEIGHT);
+    int legendHeight = std::max(MIN_LEGEND_HEIGHT, std::min(columnHeight, height / 2));
+    legendHeight = std::min(columnHeight, legendHeight);  // Don't run into the bottom bar
+    layout.legend = {0, 0, legendHeight, sideWidth};
+    layout.history = {legendHeight, 0, std::max(1, columnHeight - legendHeight), sideWidth};
+
+    // --- Right Column: Time over Stats ---
+    int timeHeight = std::max(1, std::min(columnHeight, height / 4));
+    int rightX = std::max(0, width - sideWidth);
+    layout.time = {0, rightX, timeHeight, sideWidth};
+    layout.stats = {timeHeight, rightX, std::max(1, columnHeight - timeHeight), sideWidth};
+
+    // --- Map ---
+    // Centered in the space the other panels leave, clipped to it
+    int spaceWidth = std::max(1, rightX - sideWidth);
+    int mapHeight = std::max(1, std::min(mapSize, columnHeight));
+    mapWidth = std::max(1, std::min(mapWidth, spaceWidth));
+    layout.map = {(columnHeight - mapHeight) / 2, sideWidth + (spaceWidth - mapWidth) / 2,
+                  mapHeight, mapWidth};
+
+    return layout;
+}
@@ -0,0 +1,261 @@
+#include "../include/levelpool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/difficulty.h"
+#include "../include/mapgen.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+// Fixed fields in front of the coordinate lists: seed + six 16-bit values
+const size_t RECORD_PREFIX = sizeof(uint64_t) + 6 * sizeof(uint16_t);
+
+size_t recordSizeFor(const DifficultyProfile& profile) {
+    size_t coords = 2 * profile.numPackages + profile.numStations;
+    size_t size = RECORD_PREFIX + coords * 2 * sizeof(uint16_t) +
+                  static_cast<size_t>(profile.mapSize) * profile.mapSize;
+    return (size + 7) / 8 * 8;
+}
+
+void putCoords(unsigned char*& out, const std::vector<std::pair<int, int>>& cells) {
+    for (const auto& cell : cells) {
+        uint16_t yx[2] = {static_cast<uint16_t>(cell.first), static_cast<uint16_t>(cell.second)};
+        std::memcpy(out, yx, sizeof(yx));
+        out += sizeof(yx);
+    }
+}
+
+void getCoords(const unsigned char*& in, int count, std::vector<std::pair<int, int>>& cells) {
+    cells.resize(count);
+    for (int i = 0; i < count; ++i) {
+        uint16_t yx[2];
+        std::memcpy(yx, in, sizeof(yx));
+        cells[i] = {yx[0], yx[1]};
+        in += sizeof(yx);
+    }
+}
+
+// Every cell of the list lies inside a size x size map, `width` cells wide from its x
+bool cellsInMap(const std::vector<std::pair<int, int>>& cells, int size, int width = 1) {
+    for (const auto& cell : cells) {
+        if (cell.first < 0 || cell.first >= size || cell.second < 0 ||
+            cell.second + width > size)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string levelPoolPath(int difficulty) {
+    return std::string("levels_") + difficultySettings(difficulty).key + ".pool";
+}
+
+LevelPoolHeader makeLevelPoolHeader(const DifficultyProfile& profile, int difficulty,
+                                    uint64_t count, uint64_t baseSeed) {
+    LevelPoolHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEVEL_POOL_MAGIC, sizeof(header.magic));
+    header.version = LEVEL_POOL_VERSION;
+    header.difficulty = difficulty;
+    header.mapSize = profile.mapSize;
+    header.numPackages = profile.numPackages;
+    header.numStations = profile.numStations;
+    header.recordSize = static_cast<uint32_t>(recordSizeFor(profile));
+    header.count = count;
+    header.baseSeed = baseSeed;
+    return header;
+}
+
+bool encodeLevel(const Level& level, const LevelPoolHeader& header, unsigned char* record) {
+    const int size = static_cast<int>(header.mapSize);
+    if (level.grid.width() != size || level.grid.height() != size ||
+        level.packagePickUpLocs.size() != header.numPackages ||
+        level.packageDestLocs.size() != header.numPackages ||
+        level.supplyStationLocations.size() > header.numStations)
+        return false;
+
+    std::memset(record, 0, header.recordSize);
+    unsigned char* out = record;
+    std::memcpy(out, &level.seed, sizeof(level.seed));
+    out += sizeof(level.seed);
+
+    uint16_t fields[6] = {static_cast<uint16_t>(level.startY),
+                          static_cast<uint16_t>(level.startX),
+                          static_cast<uint16_t>(level.exitY),
+                          static_cast<uint16_t>(level.exitX),
+                          static_cast<uint16_t>(level.supplyStationLocations.size()),
+                          0};
+    std::memcpy(out, fields, sizeof(fields));
+    out += sizeof(fields);
+
+    // Unused station slots stay zeroed, so every record has the same size
+    putCoords(out, level.packagePickUpLocs);
+    putCoords(out, level.packageDestLocs);
+    unsigned char* stations = out;
+    putCoords(stations, level.supplyStationLocations);
+    out += header.numStations * 2 * sizeof(uint16_t);
+
+    // The tile layer is contiguous, so the whole grid is one copy
+    std::memcpy(out, level.grid.row(0), static_cast<size_t>(size) * size);
+    return true;
+}
+
+LevelPool::LevelPool() : data(nullptr), length(0) {
+    std::memset(&header, 0, sizeof(header));
+}
+
+LevelPool::~LevelPool() {
+    close();
+}
+
+bool LevelPool::open(const std::string& path, const DifficultyProfile& profile) {
+    close();
+
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    length = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(LevelPoolHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (mapped == MAP_FAILED)
+        return false;
+    data = static_cast<const unsigned char*>(mapped);
+    length = static_cast<size_t>(info.st_size);
+#endif
+
+    // The pool must match the profile the game is about to play
+    if (length >= sizeof(header))
+        std::memcpy(&header, data, sizeof(header));
+    bool valid = length >= sizeof(header) &&
+                 std::memcmp(header.magic, LEVEL_POOL_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == LEVEL_POOL_VERSION &&
+                 header.mapSize == static_cast<uint32_t>(profile.mapSize) &&
+                 header.numPackages == static_cast<uint32_t>(profile.numPackages) &&
+                 header.numStations == static_cast<uint32_t>(profile.numStations) &&
+                 header.recordSize == recordSizeFor(profile) && header.count > 0 &&
+                 header.count <= (length - sizeof(header)) / header.recordSize;
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LevelPool::close() {
+#ifdef _WIN32
+    buffer.clear();
+#else
+    if (data)
+        munmap(const_cast<unsigned char*>(data), length);
+#endif
+    data = nullptr;
+    length = 0;
+    std::memset(&header, 0, sizeof(header));
+}
+
+bool LevelPool::isOpen() const {
+    return data != nullptr;
+}
+
+uint64_t LevelPool::size() const {
+    return isOpen() ? header.count : 0;
+}
+
+bool LevelPool::levelAt(uint64_t index, Level& level) const {
+    if (!isOpen() || index >= header.count)
+        return false;
+
+    const int size = static_cast<int>(header.mapSize);
+    const int num_pkg = static_cast<int>(header.numPackages);
+    const unsigned char* in = data + sizeof(header) + index * header.recordSize;
+
+    level = Level();
+    std::memcpy(&level.seed, in, sizeof(level.seed));
+    in += sizeof(level.seed);
+
+    uint16_t fields[6];
+    std::memcpy(fields, in, sizeof(fields));
+    in += sizeof(fields);
+    if (fields[0] >= size || fields[1] >= size || fields[2] >= size || fields[3] >= size ||
+        fields[4] > header.numStations)
+        return false;  // Damaged record, it would read past its station slots or off the map
+    level.startY = fields[0];
+    level.startX = fields[1];
+    level.exitY = fields[2];
+    level.exitX = fields[3];
+
+    getCoords(in, num_pkg, level.packagePickUpLocs);
+    getCoords(in, num_pkg, level.packageDestLocs);
+    const unsigned char* stations = in;
+    getCoords(stations, fields[4], level.supplyStationLocations);
+    in += header.numStations * 2 * sizeof(uint16_t);
+    if (!cellsInMap(level.packagePickUpLocs, size) || !cellsInMap(level.packageDestLocs, size) ||
+        !cellsInMap(level.supplyStationLocations, size, 3))
+        return false;
+
+    level.grid = TileGrid(size, size);
+    for (int y = 0; y < size; ++y) {
+        Tile* row = level.grid.row(y);
+        std::memcpy(row, in, size);
+        in += size;
+        for (int x = 0; x < size; ++x) {
+            if (row[x] > Tile::SPEED_BUMP)
+                return false;  // Not a tile, the file is damaged
+            if (row[x] == Tile::SPEED_BUMP)
+                level.speedBumpLocations.push_back({y, x});
+        }
+    }
+
+    // Id layer
+    for (int i = 0; i < num_pkg; ++i) {
+        const auto& pickup = level.packagePickUpLocs[i];
+        const auto& dest = level.packageDestLocs[i];
+        level.grid.set(pickup.first, pickup.second, Tile::PICKUP, i);
+        level.grid.set(dest.first, dest.second, Tile::DESTINATION, i);
+    }
+    for (int i = 0; i < static_cast<int>(level.supplyStationLocations.size()); ++i) {
+        const auto& station = level.supplyStationLocations[i];
+        level.grid.set(station.first, station.second, Tile::STATION_LEFT, i);
+        level.grid.set(station.first, station.second + 1, Tile::STATION_MID, i);
+        level.grid.set(station.first, station.second + 2, Tile::STATION_RIGHT, i);
+    }
+    return true;
+}
+
+bool LevelPool::levelForSeed(uint64_t seed, Level& level) const {
+    if (!isOpen())
+        return false;
+    return levelAt(seed % header.count, level);
+}
@@ -0,0 +1,64 @@
+// Pregenerates a pool of validated levels for one difficulty
+// Usage: ./bin/levelpool <difficulty index> <count> [base seed] [output file]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../include/difficulty.h"
+#include "../include/levelpool.h"
+#include "../include/levelscore.h"
+#include "../include/mapgen.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <difficulty 0-%d> <count> [base seed] [output file]\n",
+                     argv[0], NUM_DIFFICULTIES - 1);
+        return 1;
+    }
+    int difficulty = std::atoi(argv[1]);
+    long long requested = std::atoll(argv[2]);
+    uint64_t baseSeed = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1;
+    std::string path = (argc > 4) ? argv[4] : levelPoolPath(difficulty);
+
+    if (difficulty < 0 || difficulty >= NUM_DIFFICULTIES || requested <= 0) {
+        std::fprintf(stderr, "Difficulty must be 0-%d and count positive\n", NUM_DIFFICULTIES - 1);
+        return 1;
+    }
+    const uint64_t count = static_cast<uint64_t>(requested);
+
+    DifficultyProfile profile = profileForDifficulty(difficulty);
+    LevelPoolHeader header = makeLevelPoolHeader(profile, difficulty, count, baseSeed);
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return 1;
+    }
+    std::fwrite(&header, sizeof(header), 1, out);
+
+    // Same generator the game uses live; levels are written only once they validate
+    std::vector<unsigned char> record(header.recordSize);
+    uint64_t written = 0;
+    uint64_t rejected = 0;
+    for (int i = 0; written < count; ++i) {
+        Level level = generateBestLevel(profile, roundSeed(baseSeed, i));
+        if (!isLevelSolvable(level) || !encodeLevel(level, header, record.data())) {
+            rejected++;
+            continue;
+        }
+        std::fwrite(record.data(), record.size(), 1, out);
+        written++;
+    }
+
+    if (std::fclose(out) != 0) {
+        std::fprintf(stderr, "Failed to finish %s\n", path.c_str());
+        return 1;
+    }
+    std::printf("Wrote %llu levels (%u bytes each, %llu rejected) to %s\n",
+                static_cast<unsigned long long>(written), header.recordSize,
+                static_cast<unsigned long long>(rejected), path.c_str());
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include "../include/levelscore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/bitboard.h"
+#include "../include/mapgen.h"
+#include "../include/reachability.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+// A supply station at most this many steps off the tour is worth the detour
+const int STATION_REACH = 3;
+
+// Candidate i > 0 is generated from roundSeed(seed, CANDIDATE_SEED_OFFSET + i), well away from
+// the seeds of later rounds
+const int CANDIDATE_SEED_OFFSET = 1000;
+
+bool isBlocked(Tile tile) {
+    return !isWalkable(tile);
+}
+
+bool isSpeedBump(Tile tile) {
+    return tile == Tile::SPEED_BUMP;
+}
+
+}  // namespace
+
+LevelMetrics measureLevel(const Level& level) {
+    return measureLevel(level, threadScratchArena());
+}
+
+LevelMetrics measureLevel(const Level& level, Arena& scratch) {
+    ArenaScope scope(scratch);
+    const TileGrid& grid = level.grid;
+    const int width = grid.width();
+    const int cells = grid.width() * grid.height();
+    const int num_pkg = static_cast<int>(level.packagePickUpLocs.size());
+
+    LevelMetrics metrics = {0, 0, 0, 0, 0};
+
+    // One distance field per waypoint, shared by every leg of the tour that ends there.
+    // The fields sit back to back: pickup and destination of each package, then the exit.
+    const Bitboard walkable = walkableCells(grid, &scratch);
+    ArenaVector<int> fields((2 * num_pkg + 1) * cells, 0, &scratch);
+    const int* pickupFields[MAX_PACKAGES];
+    const int* destFields[MAX_PACKAGES];
+    for (int i = 0; i < num_pkg; ++i) {
+        int* pickup = &fields[(2 * i) * cells];
+        int* dest = &fields[(2 * i + 1) * cells];
+        distanceField(walkable, level.packagePickUpLocs[i].first,
+                      level.packagePickUpLocs[i].second, pickup);
+        distanceField(walkable, level.packageDestLocs[i].first, level.packageDestLocs[i].second,
+                      dest);
+        pickupFields[i] = pickup;
+        destFields[i] = dest;
+    }
+    int* exitField = &fields[2 * num_pkg * cells];
+    distanceField(walkable, level.exitY, level.exitX, exitField);
+
+    // Closest package/destination pair
+    int closest = INT_MAX;
+    for (int i = 0; i < num_pkg; ++i) {
+        int d = pickupFields[i][level.packageDestLocs[i].first * width +
+                                level.packageDestLocs[i].second];
+        if (d != UNREACHABLE)
+            closest = std::min(closest, d);
+    }
+    metrics.deliveryDistance = (closest == INT_MAX) ? 0 : closest;
+
+    // Walk from `cell` down the field to its source, marking the route
+    Bitboard onRoute(grid.width(), grid.height(), &scratch);
+    const int dy[] = {-1, 1, 0, 0};
+    const int dx[] = {0, 0, -1, 1};
+    auto walk = [&](int& cell, const int* field) {
+        metrics.tourLength += field[cell];
+        onRoute.set(cell / width, cell % width);
+        while (field[cell] > 0) {
+            int y = cell / width;
+            int x = cell % width;
+            for (int d = 0; d < 4; ++d) {
+                int next = (y + dy[d]) * width + (x + dx[d]);
+                if (field[next] == field[cell] - 1) {
+                    cell = next;
+                    break;
+                }
+            }
+            onRoute.set(cell / width, cell % width);
+        }
+    };
+
+    // Greedy tour: always go to the nearest pending pickup or held package's destination
+    int cell = level.startY * width + level.startX;
+    uint64_t picked = 0;
+    uint64_t delivered = 0;
+    for (int leg = 0; leg < 2 * num_pkg; ++leg) {
+        const int* bestField = nullptr;
+        int bestDistance = INT_MAX;
+        int bestPackage = -1;
+        for (int i = 0; i < num_pkg; ++i) {
+            if ((delivered >> i) & 1)
+                continue;
+            const int* field = ((picked >> i) & 1) ? destFields[i] : pickupFields[i];
+            if (field[cell] != UNREACHABLE && field[cell] < bestDistance) {
+                bestDistance = field[cell];
+                bestField = field;
+                bestPackage = i;
+            }
+        }
+        if (bestPackage == -1)
+            break;  // Nothing reachable left
+        walk(cell, bestField);
+        if ((picked >> bestPackage) & 1)
+            delivered |= 1ULL << bestPackage;
+        else
+            picked |= 1ULL << bestPackage;
+    }
+    if (exitField[cell] != UNREACHABLE)
+        walk(cell, exitField);
+
+    // Route statistics, as set operations on the route. A bottleneck is blocked on both sides
+    // (above and below, or left and right); the map border is blocked, so shifts never go out.
+    const Bitboard blocked = Bitboard::fromTiles(grid, isBlocked, &scratch);
+    Bitboard squeezed = blocked.shifted(1, 0) & blocked.shifted(-1, 0);
+    squeezed |= blocked.shifted(0, 1) & blocked.shifted(0, -1);
+    metrics.bumpExposure = (onRoute & Bitboard::fromTiles(grid, isSpeedBump, &scratch)).count();
+    metrics.bottlenecks = (onRoute & squeezed).count();
+
+    for (const auto& station : level.supplyStationLocations) {
+        Bitboard nearStation = floodFill(walkable, station.first, station.second, STATION_REACH);
+        if ((nearStation &= onRoute).any())
+            metrics.usefulStations++;
+    }
+
+    return metrics;
+}
+
+double scoreLevel(const LevelMetrics& metrics, const ScoreWeights& weights) {
+    return weights.tourLength * metrics.tourLength +
+           weights.deliveryDistance * metrics.deliveryDistance +
+           weights.bottlenecks * metrics.bottlenecks + weights.bumpExposure * metrics.bumpExposure +
+           weights.usefulStations * metrics.usefulStations;
+}
+
+Level generateBestLevel(const DifficultyProfile& profile, uint64_t seed) {
+    std::vector<Arena> scratch;
+    return generateBestLevel(profile, seed, scratch);
+}
+
+Level generateBestLevel(const DifficultyProfile& profile, uint64_t seed,
+                        std::vector<Arena>& scratch) {
+    const int numCandidates = std::max(1, profile.candidates);
+    int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    int numThreads = std::min(numCandidates, std::max(1, hardwareThreads));
+    while (static_cast<int>(scratch.size()) < numThreads) {
+        scratch.emplace_back();
+    }
+    if (numCandidates == 1)
+        return generatePlayableLevel(profile, seed, scratch[0]);
+
+    std::vector<Level> levels(numCandidates);
+    std::vector<double> scores(numCandidates, 0.0);
+    std::atomic<int> nextCandidate(0);
+
+    // Workers pull candidate indices until all are taken
+    auto worker = [&](Arena& arena) {
+        for (;;) {
+            int i = nextCandidate.fetch_add(1);
+            if (i >= numCandidates)
+                return;
+            uint64_t candidateSeed = (i == 0) ? seed : roundSeed(seed, CANDIDATE_SEED_OFFSET + i);
+            levels[i] = generatePlayableLevel(profile, candidateSeed, arena);
+            scores[i] = scoreLevel(measureLevel(levels[i], arena), profile.weights);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; ++t) {
+        threads.emplace_back(worker, std::ref(scratch[t]));
+    }
+    worker(scratch[0]);  // The calling thread takes candidates as well
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Best score wins, ties go to the lower candidate index
+    int best = 0;
+    for (int i = 1; i < numCandidates; ++i) {
+        if (scores[i] > scores[best])
+            best = i;
+    }
+    return std::move(levels[best]);
+}
@@ -1,8 +1,17 @@
 #include "../include/game.h"
 
-int main() {
+#include <cstring>
+
+int main(int argc, char* argv[]) {
+    // --daily plays the same level sequence as everyone else today
+    bool dailyChallenge = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--daily") == 0)
+            dailyChallenge = true;
+    }
+
     // Creates game instance and run game
-    Game game;
+    Game game(dailyChallenge);
     game.run();
 
     return 0;
@@ -0,0 +1,368 @@
+#include "../include/mapgen.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/bitboard.h"
+#include "../include/difficulty.h"
+#include "../include/occupancy.h"
+#include "../include/reachability.h"
+#include "../include/rng.h"
+#include "../include/terrain.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+// Every cell the player must (or should be able to) reach: pickups, destinations,
+// one cell of each supply station and the exit
+ArenaVector<std::pair<int, int>> levelTargets(const Level& level, Arena* arena = nullptr) {
+    ArenaVector<std::pair<int, int>> targets(arena);
+    targets.insert(targets.end(), level.packagePickUpLocs.begin(), level.packagePickUpLocs.end());
+    targets.insert(targets.end(), level.packageDestLocs.begin(), level.packageDestLocs.end());
+    targets.insert(targets.end(), level.supplyStationLocations.begin(),
+                   level.supplyStationLocations.end());
+    targets.push_back({level.exitY, level.exitX});
+    return targets;
+}
+
+// Generate a level and repair it if the start cannot reach everything; only a level that is
+// complete and solvable counts
+bool tryLevel(const DifficultyProfile& profile, uint64_t seed, Level& level, Arena& scratch) {
+    if (!generateLevel(profile, seed, level, scratch))
+        return false;
+    return isLevelSolvable(level) || repairLevel(level);
+}
+
+}  // namespace
+
+const DifficultySettings& difficultySettings(int difficulty) {
+    if (difficulty < 0 || difficulty >= NUM_DIFFICULTIES)
+        difficulty = 0;
+    return DIFFICULTIES[difficulty];
+}
+
+bool operator==(const ScoreWeights& a, const ScoreWeights& b) {
+    return a.tourLength == b.tourLength && a.deliveryDistance == b.deliveryDistance &&
+           a.bottlenecks == b.bottlenecks && a.bumpExposure == b.bumpExposure &&
+           a.usefulStations == b.usefulStations;
+}
+
+bool operator==(const DifficultyProfile& a, const DifficultyProfile& b) {
+    return a.mapSize == b.mapSize && a.numPackages == b.numPackages &&
+           a.minPackageDistance == b.minPackageDistance &&
+           a.minDestinationDistance == b.minDestinationDistance && a.numStripes == b.numStripes &&
+           a.minStripeLength == b.minStripeLength && a.maxStripeLength == b.maxStripeLength &&
+           a.numClusters == b.numClusters && a.clusterSize == b.clusterSize &&
+           a.maxBlocksPerRow == b.maxBlocksPerRow && a.numStations == b.numStations &&
+           a.minPatches == b.minPatches && a.maxPatches == b.maxPatches &&
+           a.minPatchRows == b.minPatchRows && a.maxPatchRows == b.maxPatchRows &&
+           a.minPatchCols == b.minPatchCols && a.maxPatchCols == b.maxPatchCols &&
+           a.terrain == b.terrain && a.obstacleDensity == b.obstacleDensity &&
+           a.noiseScale == b.noiseScale && a.caveIterations == b.caveIterations &&
+           a.candidates == b.candidates && a.weights == b.weights;
+}
+
+DifficultyProfile profileForDifficulty(int difficulty) {
+    return difficultySettings(difficulty).profile;
+}
+
+uint64_t roundSeed(uint64_t sessionSeed, int roundNumber) {
+    // splitmix64 finalizer, so consecutive rounds get unrelated seeds
+    uint64_t z = sessionSeed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(roundNumber + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t dailySeed() {
+    // Days since the epoch, mixed so neighbouring days are unrelated
+    const uint64_t DAILY_SALT = 0x4B45455441444159ULL;
+    int64_t day = static_cast<int64_t>(std::time(nullptr)) / 86400;
+    return roundSeed(DAILY_SALT, static_cast<int>(day));
+}
+
+bool generateLevel(const DifficultyProfile& profile, uint64_t seed, Level& level) {
+    return generateLevel(profile, seed, level, threadScratchArena());
+}
+
+bool generateLevel(const DifficultyProfile& profile, uint64_t seed, Level& level,
+                   Arena& scratch) {
+    ArenaScope scope(scratch);
+    const int map_size = profile.mapSize;
+    const int num_pkg = std::min(profile.numPackages, MAX_PACKAGES);
+
+    Rng rng(seed, RngStream::LAYOUT);
+
+    // Start from a blank level in the storage of the previous one; a failed attempt leaves
+    // its partial placement behind, so every list starts over
+    level.seed = seed;
+    level.packagePickUpLocs.clear();
+    level.packageDestLocs.clear();
+    level.packagePickUpLocs.reserve(num_pkg);
+    level.packageDestLocs.reserve(num_pkg);
+    level.supplyStationLocations.clear();
+    level.speedBumpLocations.clear();
+    TileGrid& mapGrid = level.grid;
+    std::vector<std::pair<int, int>>& packagePickUpLocs = level.packagePickUpLocs;
+    std::vector<std::pair<int, int>>& packageDestLocs = level.packageDestLocs;
+
+    mapGrid.reset(map_size, map_size);
+
+    // Top and Bottom borders
+    mapGrid.fillSpan(0, 0, map_size, Tile::BORDER_H);
+    mapGrid.fillSpan(map_size - 1, 0, map_size, Tile::BORDER_H);
+    // Left and Right borders
+    for (int y = 1; y < map_size - 1; ++y) {
+        mapGrid.set(y, 0, Tile::BORDER_V);
+        mapGrid.set(y, map_size - 1, Tile::BORDER_V);
+    }
+    // Corners
+    mapGrid.set(0, 0, Tile::CORNER);
+    mapGrid.set(0, map_size - 1, Tile::CORNER);
+    mapGrid.set(map_size - 1, 0, Tile::CORNER);
+    mapGrid.set(map_size - 1, map_size - 1, Tile::CORNER);
+
+    // Define Player Start and Exit Locations
+    const int playerY = map_size / 2;
+    const int playerX = 1;
+    const int exitY = map_size / 2;
+    const int exitX = map_size - 2;
+    level.startY = playerY;
+    level.startX = playerX;
+    level.exitY = exitY;
+    level.exitX = exitX;
+    mapGrid.set(exitY, exitX, Tile::EXIT);  // Place exit marker
+
+    // Obstacles come from the profile's terrain generator
+    terrainGenerator(profile.terrain).carve(profile, rng, level, scratch);
+
+    // If the obstacles wall off the exit, the cheapest path to it is opened before anything
+    // is placed: retrying the same seed would only build the same walls again
+    const int cells = map_size * map_size;
+    Bitboard walkable = walkableCells(mapGrid, &scratch);  // Pickups stay walkable
+    ArenaVector<int> fromStart(cells, 0, &scratch);
+    distanceField(walkable, playerY, playerX, fromStart.data());
+    if (fromStart[exitY * map_size + exitX] == UNREACHABLE) {
+        carvePath(mapGrid, playerY, playerX, exitY, exitX);
+        walkable = walkableCells(mapGrid, &scratch);
+        distanceField(walkable, playerY, playerX, fromStart.data());
+    }
+
+    // Everything placed so far (borders, exit, obstacles) is occupied; the start is protected too
+    OccupancyIndex occupancy(mapGrid, &scratch);
+    occupancy.markOccupied(playerY, playerX);
+
+    // Packages are placed once the obstacles stand, so spacing is measured in actual steps.
+    // Only cells reachable from the start are candidates, visited in random order; each one
+    // is looked at a bounded number of times, so placement can never spin forever.
+
+    ArenaVector<std::pair<int, int>> candidates(&scratch);
+    candidates.reserve((map_size - 2) * (map_size - 2));
+    for (int y = 1; y < map_size - 1; ++y) {
+        for (int x = 1; x < map_size - 1; ++x) {
+            if (mapGrid.at(y, x) == Tile::FLOOR && !occupancy.isOccupied(y, x) &&
+                fromStart[y * map_size + x] != UNREACHABLE)
+                candidates.push_back({y, x});
+        }
+    }
+    shuffleVector(candidates, rng);
+
+    // Generate Package Pickup Locations
+    // nearestPackage holds the walking distance to the closest placed package; it is folded
+    // with each new package's distance field, so a candidate check is a single lookup
+    // Package i's field is pickupFields[i * cells ..]
+    ArenaVector<int> pickupFields(num_pkg * cells, 0, &scratch);
+    ArenaVector<int> nearestPackage(cells, INT_MAX, &scratch);
+    int packagesPlaced = 0;
+    for (const auto& cell : candidates) {
+        if (packagesPlaced == num_pkg)
+            break;
+        if (nearestPackage[cell.first * map_size + cell.second] < profile.minPackageDistance)
+            continue;
+        packagePickUpLocs.push_back(cell);
+        mapGrid.set(cell.first, cell.second, Tile::PICKUP, packagesPlaced);
+        occupancy.markOccupied(cell.first, cell.second);
+
+        int* field = &pickupFields[packagesPlaced * cells];
+        distanceField(walkable, cell.first, cell.second, field);
+        for (int i = 0; i < cells; ++i) {
+            if (field[i] != UNREACHABLE)
+                nearestPackage[i] = std::min(nearestPackage[i], field[i]);
+        }
+        packagesPlaced++;
+    }
+    if (packagesPlaced < num_pkg)
+        return false;  // Not enough room for the requested spacing
+
+    // Generate Corresponding Destination Locations
+    // Each destination scans the candidate list once, starting where the previous one stopped,
+    // and reuses its package's distance field
+    size_t cursor = 0;
+    for (int i = 0; i < num_pkg; ++i) {
+        bool placed = false;
+        for (size_t n = 0; n < candidates.size() && !placed; ++n) {
+            const auto& cell = candidates[(cursor + n) % candidates.size()];
+            if (mapGrid.at(cell.first, cell.second) != Tile::FLOOR ||
+                pickupFields[i * cells + cell.first * map_size + cell.second] <
+                    profile.minDestinationDistance)
+                continue;
+            packageDestLocs.push_back(cell);
+            mapGrid.set(cell.first, cell.second, Tile::DESTINATION, i);
+            occupancy.markOccupied(cell.first, cell.second);
+            cursor = (cursor + n + 1) % candidates.size();
+            placed = true;
+        }
+        if (!placed)
+            return false;  // No cell far enough from this package
+    }
+
+    // --- Place Supply Station [$] ---
+    int stationsPlaced = 0;
+    int supplyAttempts = 0;
+    int maxSupplyAttempts = map_size * map_size * 2;
+
+    while (stationsPlaced < profile.numStations && supplyAttempts < maxSupplyAttempts) {
+        supplyAttempts++;
+        int y = randBelow(rng, map_size - 2) + 1;
+        int x = randBelow(rng, map_size - 4) + 1;
+
+        // Stations in a walled-off pocket would be useless
+        if (occupancy.spanFree(y, x, 3) && fromStart[y * map_size + x] != UNREACHABLE) {
+            mapGrid.set(y, x, Tile::STATION_LEFT, stationsPlaced);
+            mapGrid.set(y, x + 1, Tile::STATION_MID, stationsPlaced);
+            mapGrid.set(y, x + 2, Tile::STATION_RIGHT, stationsPlaced);
+            occupancy.markSpanOccupied(y, x, 3);
+
+            level.supplyStationLocations.push_back({y, x});
+            stationsPlaced++;
+        }
+    }
+
+    // --- Place Speed Bumps [~] ---
+    const int minY = profile.minPatchRows;
+    const int maxY = profile.maxPatchRows;
+    const int minX = profile.minPatchCols;
+    const int maxX = profile.maxPatchCols;
+    int numPatches =
+        profile.minPatches + randBelow(rng, profile.maxPatches - profile.minPatches + 1);
+
+    int patchesPlaced = 0;
+    int maxAttempts = map_size * map_size * 2;
+    int attempts = 0;
+
+    while (patchesPlaced < numPatches && attempts < maxAttempts) {
+        attempts++;
+
+        int patchRows = minY + randBelow(rng, maxY - minY + 1);
+
+        int patchStartY = randBelow(rng, map_size - patchRows - 2) + 1;
+        int patchStartX = randBelow(rng, map_size - maxX - 2) + 1;
+
+        bool placedPatch = false;
+
+        for (int row = 0; row < patchRows; row++) {
+            int y = patchStartY + row;
+
+            // Randomize starting x with slight offset
+            int rowStartX = patchStartX + randBelow(rng, 3);  // 0, 1 or 2 offset
+            int rowEndX = std::min(map_size - 1, rowStartX + minX + randBelow(rng, maxX - minX + 1));
+
+            // Walk the row run by run: free runs are filled whole, occupied cells are skipped
+            int x = rowStartX;
+            while (x < rowEndX) {
+                int run = std::min(occupancy.freeRun(y, x), rowEndX - x);
+                if (run == 0) {
+                    x++;
+                    continue;
+                }
+                for (int i = 0; i < run; ++i) {
+                    level.speedBumpLocations.push_back({y, x + i});
+                }
+                mapGrid.fillSpan(y, x, run, Tile::SPEED_BUMP);
+                occupancy.markSpanOccupied(y, x, run);
+                placedPatch = true;
+                x += run;
+            }
+        }
+
+        if (placedPatch)
+            patchesPlaced++;
+    }
+
+    return true;
+}
+
+int countUnreachableTargets(const Level& level) {
+    // Runs after every generated level, so it works in scratch memory too
+    Arena& scratch = threadScratchArena();
+    ArenaScope scope(scratch);
+    Bitboard reached =
+        floodFill(walkableCells(level.grid, &scratch), level.startY, level.startX);
+
+    int unreachable = 0;
+    for (const auto& target : levelTargets(level, &scratch)) {
+        if (!reached.test(target.first, target.second))
+            unreachable++;
+    }
+    return unreachable;
+}
+
+bool isLevelSolvable(const Level& level) {
+    return countUnreachableTargets(level) == 0;
+}
+
+bool repairLevel(Level& level) {
+    Bitboard reached = floodFill(level.grid, level.startY, level.startX);
+
+    for (const auto& target : levelTargets(level)) {
+        if (reached.test(target.first, target.second))
+            continue;
+        carvePath(level.grid, level.startY, level.startX, target.first, target.second);
+        reached = floodFill(level.grid, level.startY, level.startX);
+    }
+    return isLevelSolvable(level);
+}
+
+Level generatePlayableLevel(const DifficultyProfile& profile, uint64_t seed) {
+    return generatePlayableLevel(profile, seed, threadScratchArena());
+}
+
+Level generatePlayableLevel(const DifficultyProfile& profile, uint64_t seed, Arena& scratch) {
+    Level level;
+    if (tryLevel(profile, seed, level, scratch))
+        return level;
+
+    // Retry with new seeds drawn from the seed's own stream, so the result stays deterministic
+    Rng retrySeeds(seed, RngStream::RETRIES);
+    for (int attempt = 1; attempt < MAX_GENERATION_ATTEMPTS; ++attempt) {
+        if (tryLevel(profile, retrySeeds(), level, scratch))
+            return level;
+    }
+
+    // The spacing rules are too strict for this terrain: relax them step by step, each step
+    // on a new seed
+    DifficultyProfile relaxed = profile;
+    while (relaxed.minPackageDistance > 0 || relaxed.minDestinationDistance > 0) {
+        relaxed.minPackageDistance = std::max(0, relaxed.minPackageDistance - 1);
+        relaxed.minDestinationDistance = std::max(0, relaxed.minDestinationDistance - 1);
+        if (tryLevel(relaxed, retrySeeds(), level, scratch))
+            return level;
+    }
+
+    // The terrain leaves too little open floor for the packages: fall back to the classic
+    // terrain, and finally to a map without obstacles
+    relaxed.terrain = TerrainKind::CLASSIC;
+    for (int attempt = 0; attempt < MAX_GENERATION_ATTEMPTS; ++attempt) {
+        if (tryLevel(relaxed, retrySeeds(), level, scratch))
+            return level;
+    }
+    relaxed.numStripes = 0;
+    relaxed.numClusters = 0;
+    tryLevel(relaxed, seed, level, scratch);  // Always has room, see difficultiesAreValid()
+    return level;
+}
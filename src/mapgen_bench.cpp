@@ -0,0 +1,206 @@
+// Headless map generation benchmark
+// Usage: ./bin/mapgen_bench [maps per difficulty] [base seed]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/difficulty.h"
+#include "../include/levelscore.h"
+#include "../include/mapgen.h"
+
+namespace {
+
+// Every heap allocation of the process, from all threads
+std::atomic<size_t> heapAllocations(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// Latency (microseconds) at the given percentile of a sorted sample
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int mapsPerDifficulty = 2000;
+    uint64_t baseSeed = 12345;
+    if (argc > 1)
+        mapsPerDifficulty = std::max(1, std::atoi(argv[1]));
+    if (argc > 2)
+        baseSeed = std::strtoull(argv[2], nullptr, 10);
+
+    std::printf("%-8s %6s %8s %7s %7s %10s %9s %9s %9s %12s %12s %11s\n", "Diff", "Size",
+                "Maps", "Failed", "Unsolv", "Maps/s", "p50(us)", "p99(us)", "max(us)",
+                "valid50(us)", "valid99(us)", "Allocs/map");
+
+    for (int diff = 0; diff < NUM_DIFFICULTIES; ++diff) {
+        const DifficultySettings& settings = difficultySettings(diff);
+        const DifficultyProfile& profile = settings.profile;
+        std::vector<double> latencies;
+        std::vector<double> validationLatencies;
+        latencies.reserve(mapsPerDifficulty);
+        validationLatencies.reserve(mapsPerDifficulty);
+
+        // Guard against the optimizer throwing the levels away
+        uint64_t checksum = 0;
+        int failed = 0;
+        int unsolvable = 0;
+        Level level;
+        size_t allocations = 0;
+
+        auto benchStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < mapsPerDifficulty; ++i) {
+            size_t allocationsBefore = heapAllocations.load();
+            auto start = std::chrono::steady_clock::now();
+            bool ok = generateLevel(profile, roundSeed(baseSeed, i), level);
+            auto end = std::chrono::steady_clock::now();
+            allocations += heapAllocations.load() - allocationsBefore;
+
+            if (!ok) {
+                failed++;
+            } else {
+                // Reachability validation is timed on its own
+                auto validateStart = std::chrono::steady_clock::now();
+                bool solvable = isLevelSolvable(level);
+                auto validateEnd = std::chrono::steady_clock::now();
+                if (!solvable)
+                    unsolvable++;
+                validationLatencies.push_back(
+                    std::chrono::duration<double, std::micro>(validateEnd - validateStart).count());
+            }
+            checksum += static_cast<int>(level.grid.at(level.exitY, level.exitX)) +
+                        level.speedBumpLocations.size();
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        auto benchEnd = std::chrono::steady_clock::now();
+
+        double totalSeconds = std::chrono::duration<double>(benchEnd - benchStart).count();
+        std::sort(latencies.begin(), latencies.end());
+        std::sort(validationLatencies.begin(), validationLatencies.end());
+
+        std::string size = std::to_string(profile.mapSize) + "x" + std::to_string(profile.mapSize);
+        std::printf("%-8s %6s %8d %7d %7d %10.0f %9.1f %9.1f %9.1f %12.2f %12.2f %11.2f\n",
+                    settings.name, size.c_str(), mapsPerDifficulty, failed, unsolvable,
+                    mapsPerDifficulty / totalSeconds, percentile(latencies, 0.50),
+                    percentile(latencies, 0.99), latencies.back(),
+                    percentile(validationLatencies, 0.50), percentile(validationLatencies, 0.99),
+                    static_cast<double>(allocations) / mapsPerDifficulty);
+
+        if (checksum == 0)
+            std::printf("(empty checksum)\n");
+    }
+
+    // Best-of-N: full round generation cost and how much the scorer improves the level
+    int roundsPerDifficulty = std::max(1, mapsPerDifficulty / 20);
+    std::printf("\n%-8s %6s %8s %10s %9s %9s %9s %10s %10s %11s\n", "Diff", "N", "Rounds",
+                "Rounds/s", "p50(us)", "p99(us)", "max(us)", "FirstScore", "BestScore",
+                "Allocs/rnd");
+
+    // Kept across rounds like the game's prefetcher does
+    std::vector<Arena> workerScratch;
+
+    for (int diff = 0; diff < NUM_DIFFICULTIES; ++diff) {
+        const DifficultySettings& settings = difficultySettings(diff);
+        const DifficultyProfile& profile = settings.profile;
+        std::vector<double> latencies;
+        double firstScoreSum = 0.0;
+        double bestScoreSum = 0.0;
+        size_t allocations = 0;
+
+        for (int i = 0; i < roundsPerDifficulty; ++i) {
+            uint64_t seed = roundSeed(baseSeed, i);
+            size_t allocationsBefore = heapAllocations.load();
+            auto start = std::chrono::steady_clock::now();
+            Level best = generateBestLevel(profile, seed, workerScratch);
+            auto end = std::chrono::steady_clock::now();
+            allocations += heapAllocations.load() - allocationsBefore;
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+            // Candidate 0 is what plain generation would have produced
+            bestScoreSum += scoreLevel(measureLevel(best), profile.weights);
+            firstScoreSum +=
+                scoreLevel(measureLevel(generatePlayableLevel(profile, seed)), profile.weights);
+        }
+        // Only the timed generateBestLevel() calls count towards throughput
+        double totalSeconds = 0.0;
+        for (double latency : latencies) {
+            totalSeconds += latency / 1e6;
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        std::printf("%-8s %6d %8d %10.0f %9.1f %9.1f %9.1f %10.2f %10.2f %11.1f\n",
+                    settings.name, profile.candidates, roundsPerDifficulty,
+                    roundsPerDifficulty / totalSeconds, percentile(latencies, 0.50),
+                    percentile(latencies, 0.99), latencies.back(),
+                    firstScoreSum / roundsPerDifficulty, bestScoreSum / roundsPerDifficulty,
+                    static_cast<double>(allocations) / roundsPerDifficulty);
+    }
+
+    // Large maps: cost of each terrain generator at 256x256
+    const int largeMaps = std::max(1, mapsPerDifficulty / 100);
+    const TerrainKind kinds[] = {TerrainKind::CLASSIC, TerrainKind::NOISE, TerrainKind::CAVE};
+    const char* kindNames[] = {"Classic", "Noise", "Cave"};
+    std::printf("\n%-8s %8s %8s %7s %9s %9s\n", "Terrain", "Size", "Maps", "Failed", "p50(ms)",
+                "max(ms)");
+
+    for (int k = 0; k < 3; ++k) {
+        DifficultyProfile profile = profileForDifficulty(2);
+        profile.mapSize = 256;
+        profile.terrain = kinds[k];
+        // Scale the classic obstacle counts with the map area
+        profile.numStripes *= 100;
+        profile.numClusters *= 100;
+        if (kinds[k] == TerrainKind::CAVE)
+            profile.obstacleDensity = 45;
+
+        std::vector<double> latencies;
+        int failed = 0;
+        Level level;
+        for (int i = 0; i < largeMaps; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            if (!generateLevel(profile, roundSeed(baseSeed, i), level))
+                failed++;
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        std::printf("%-8s %8s %8d %7d %9.2f %9.2f\n", kindNames[k], "256x256", largeMaps, failed,
+                    percentile(latencies, 0.50), latencies.back());
+    }
+
+    // Scratch memory a single generation thread needed at its busiest
+    std::printf("\nScratch arena peak: %zu KB in %zu heap blocks\n",
+                threadScratchArena().peakBytes() / 1024, threadScratchArena().blockAllocations());
+
+    return 0;
+}
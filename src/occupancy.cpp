@@ -0,0 +1,114 @@
+#include "../include/occupancy.h"
+
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/tilegrid.h"
+
+OccupancyIndex::OccupancyIndex(const TileGrid& grid, Arena* arena)
+    : size(grid.height()),
+      occupied(size * size, 0, ArenaAllocator<uint8_t>(arena)),
+      runRight(size * size, 0, ArenaAllocator<int>(arena)),
+      occupiedTree((size + 1) * (size + 1), 0, ArenaAllocator<int>(arena)) {
+    const int stride = size + 1;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            occupied[y * size + x] = grid.at(y, x) != Tile::FLOOR;
+            occupiedTree[(y + 1) * stride + x + 1] = occupied[y * size + x];
+        }
+        // Free runs are built right to left
+        for (int x = size - 1; x >= 0; --x) {
+            int next = (x + 1 < size) ? runRight[y * size + x + 1] : 0;
+            runRight[y * size + x] = occupied[y * size + x] ? 0 : next + 1;
+        }
+    }
+
+    // Fenwick tree in linear time: each node passes its total on to its parent, first along
+    // every row, then along every column
+    for (int y = 1; y <= size; ++y) {
+        for (int x = 1; x <= size; ++x) {
+            int parent = x + (x & -x);
+            if (parent <= size)
+                occupiedTree[y * stride + parent] += occupiedTree[y * stride + x];
+        }
+    }
+    for (int y = 1; y <= size; ++y) {
+        int parent = y + (y & -y);
+        if (parent > size)
+            continue;
+        for (int x = 1; x <= size; ++x) {
+            occupiedTree[parent * stride + x] += occupiedTree[y * stride + x];
+        }
+    }
+}
+
+void OccupancyIndex::markOccupied(int y, int x) {
+    if (occupied[y * size + x])
+        return;
+    occupied[y * size + x] = 1;
+    addOccupied(y, x);
+    updateRun(y, x);
+}
+
+void OccupancyIndex::markSpanOccupied(int y, int x, int len) {
+    for (int i = 0; i < len; ++i) {
+        if (!occupied[y * size + x + i]) {
+            occupied[y * size + x + i] = 1;
+            addOccupied(y, x + i);
+        }
+        runRight[y * size + x + i] = 0;
+    }
+    updateRun(y, x);
+}
+
+bool OccupancyIndex::isOccupied(int y, int x) const {
+    return occupied[y * size + x] != 0;
+}
+
+bool OccupancyIndex::rectFree(int y0, int x0, int y1, int x1) const {
+    return rectSum(y0, x0, y1, x1) == 0;
+}
+
+bool OccupancyIndex::spanFree(int y, int x, int len) const {
+    return freeRun(y, x) >= len;
+}
+
+int OccupancyIndex::freeRun(int y, int x) const {
+    return runRight[y * size + x];
+}
+
+// Cell (y, x) just became occupied: the runs to its left now end here
+void OccupancyIndex::updateRun(int y, int x) {
+    int* row = &runRight[y * size];
+    row[x] = 0;
+    for (int c = x - 1; c >= 0 && row[c] > 0; --c) {
+        row[c] = row[c + 1] + 1;
+    }
+}
+
+// Count one more occupied cell at (y, x) in every tree node that covers it
+void OccupancyIndex::addOccupied(int y, int x) {
+    const int stride = size + 1;
+    for (int i = y + 1; i <= size; i += i & -i) {
+        for (int j = x + 1; j <= size; j += j & -j) {
+            occupiedTree[i * stride + j]++;
+        }
+    }
+}
+
+// Occupied cells in rows < y and columns < x
+int OccupancyIndex::countBefore(int y, int x) const {
+    const int stride = size + 1;
+    int count = 0;
+    for (int i = y; i > 0; i -= i & -i) {
+        for (int j = x; j > 0; j -= j & -j) {
+            count += occupiedTree[i * stride + j];
+        }
+    }
+    return count;
+}
+
+int OccupancyIndex::rectSum(int y0, int x0, int y1, int x1) const {
+    return countBefore(y1 + 1, x1 + 1) - countBefore(y0, x1 + 1) - countBefore(y1 + 1, x0) +
+           countBefore(y0, x0);
+}
@@ -0,0 +1,41 @@
+#include "../include/prefetch.h"
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/levelscore.h"
+#include "../include/mapgen.h"
+
+LevelPrefetcher::LevelPrefetcher() : pendingProfile(), pendingSeed(0) {
+}
+
+LevelPrefetcher::~LevelPrefetcher() {
+    cancel();
+}
+
+void LevelPrefetcher::start(const DifficultyProfile& profile, uint64_t seed) {
+    cancel();
+    pendingProfile = profile;
+    pendingSeed = seed;
+    // Explicit overload: generateBestLevel has more than one
+    Level (*generate)(const DifficultyProfile&, uint64_t, std::vector<Arena>&) = generateBestLevel;
+    pending = std::async(std::launch::async, generate, profile, seed, std::ref(scratch));
+}
+
+Level LevelPrefetcher::take(const DifficultyProfile& profile, uint64_t seed) {
+    if (pending.valid()) {
+        if (pendingSeed == seed && pendingProfile == profile)
+            return pending.get();
+        cancel();  // Stale prefetch for another round or difficulty
+    }
+    return generateBestLevel(profile, seed, scratch);
+}
+
+void LevelPrefetcher::cancel() {
+    if (pending.valid())
+        pending.wait();
+    pending = std::future<Level>();
+}
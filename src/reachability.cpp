@@ -0,0 +1,117 @@
+#include "../include/reachability.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/bitboard.h"
+#include "../include/tilegrid.h"
+
+Bitboard walkableCells(const TileGrid& grid, Arena* arena) {
+    return Bitboard::fromTiles(grid, isWalkable, arena);
+}
+
+Bitboard floodFill(const TileGrid& grid, int startY, int startX) {
+    return floodFill(walkableCells(grid), startY, startX);
+}
+
+std::vector<int> distanceField(const TileGrid& grid, int startY, int startX) {
+    return distanceField(walkableCells(grid), startY, startX);
+}
+
+std::vector<int> distanceField(const Bitboard& walkable, int startY, int startX) {
+    std::vector<int> distance(walkable.height() * walkable.width());
+    distanceField(walkable, startY, startX, distance.data());
+    return distance;
+}
+
+void distanceField(const Bitboard& walkable, int startY, int startX, int* distance) {
+    const int height = walkable.height();
+    const int width = walkable.width();
+    const int words = walkable.wordsPerRow();
+    std::fill(distance, distance + height * width, UNREACHABLE);
+    if (!walkable.test(startY, startX))
+        return;
+
+    Bitboard reached(width, height, walkable.arena());
+    Bitboard frontier(width, height, walkable.arena());
+    Bitboard next(width, height, walkable.arena());
+    reached.set(startY, startX);
+    frontier.set(startY, startX);
+    distance[startY * width + startX] = 0;
+
+    // Every cell first reached by layer d is exactly d steps away
+    int firstRow = startY;
+    int lastRow = startY;
+    for (int d = 1;; ++d) {
+        int oldFirst = firstRow;
+        int oldLast = lastRow;
+        if (!expandFrontier(frontier, walkable, reached, next, firstRow, lastRow))
+            break;
+        for (int y = firstRow; y <= lastRow; ++y) {
+            const uint64_t* row = next.row(y);
+            for (int k = 0; k < words; ++k) {
+                for (uint64_t word = row[k]; word; word &= word - 1) {
+                    distance[y * width + k * 64 + lowestBit(word)] = d;
+                }
+            }
+        }
+        frontier.clearRows(oldFirst, oldLast);
+        std::swap(frontier, next);
+    }
+}
+
+int carvePath(TileGrid& grid, int startY, int startX, int targetY, int targetX) {
+    const int height = grid.height();
+    const int width = grid.width();
+    const int unvisited = std::numeric_limits<int>::max();
+    std::vector<int> cost(height * width, unvisited);
+    std::vector<int> parent(height * width, -1);
+
+    // 0-1 BFS: walkable cells cost nothing, obstacles cost one, the border is never crossed
+    std::deque<int> queue;
+    cost[startY * width + startX] = 0;
+    queue.push_back(startY * width + startX);
+
+    const int dy[] = {-1, 1, 0, 0};
+    const int dx[] = {0, 0, -1, 1};
+    while (!queue.empty()) {
+        int cell = queue.front();
+        queue.pop_front();
+        int y = cell / width;
+        int x = cell % width;
+        for (int d = 0; d < 4; ++d) {
+            int ny = y + dy[d];
+            int nx = x + dx[d];
+            if (ny <= 0 || ny >= height - 1 || nx <= 0 || nx >= width - 1)
+                continue;
+            int next = ny * width + nx;
+            int step = grid.at(next) == Tile::WALL ? 1 : 0;
+            if (cost[cell] + step < cost[next]) {
+                cost[next] = cost[cell] + step;
+                parent[next] = cell;
+                if (step == 0)
+                    queue.push_front(next);
+                else
+                    queue.push_back(next);
+            }
+        }
+    }
+
+    // Walk back from the target and clear every obstacle on the way
+    int cleared = 0;
+    int cell = targetY * width + targetX;
+    if (cost[cell] == unvisited)
+        return 0;
+    while (cell != -1) {
+        if (grid.at(cell) == Tile::WALL) {
+            grid.set(cell / width, cell % width, Tile::FLOOR);
+            cleared++;
+        }
+        cell = parent[cell];
+    }
+    return cleared;
+}
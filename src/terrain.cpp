@@ -0,0 +1,458 @@
+#include "../include/terrain.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include "../include/arena.h"
+#include "../include/bitboard.h"
+#include "../include/occupancy.h"
+#include "../include/rng.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+bool isNotFloor(Tile tile) {
+    return tile != Tile::FLOOR;
+}
+
+// Turn the cells of a wall mask into walls. Only floor becomes a wall, and the start, the exit
+// and their neighbours are masked out.
+void writeWalls(Bitboard& walls, Level& level) {
+    const int size = level.grid.width();
+    Bitboard keepClear(size, size, walls.arena());
+    keepClear.set(level.startY, level.startX);
+    keepClear.set(level.exitY, level.exitX);
+    walls.andNot(keepClear.dilated());
+    walls.andNot(Bitboard::fromTiles(level.grid, isNotFloor, walls.arena()));
+
+    for (int y = 0; y < size; ++y) {
+        const uint64_t* row = walls.row(y);
+        for (int k = 0; k < walls.wordsPerRow(); ++k) {
+            for (uint64_t word = row[k]; word; word &= word - 1) {
+                level.grid.set(y, k * 64 + lowestBit(word), Tile::WALL);
+            }
+        }
+    }
+}
+
+// Join every open region of the map to the largest one, so no part of it (the start and the
+// exit included) is walled off. A 0-1 BFS out of the largest region, where stepping onto a
+// wall costs one and open cells are free, gives every cell the fewest walls between it and
+// that region; each other region then clears the walls on the path from its cheapest cell.
+// One search serves all regions.
+void connectRegions(Level& level, Arena& scratch) {
+    ArenaScope scope(scratch);
+    TileGrid& grid = level.grid;
+    const int size = grid.width();
+    const int cells = size * size;
+    const int steps[] = {-size, size, -1, 1};
+
+    // Label the open regions
+    ArenaVector<int> region(cells, -1, &scratch);
+    ArenaVector<int> regionSize(&scratch);
+    ArenaVector<int> queue(cells, 0, &scratch);
+    for (int cell = 0; cell < cells; ++cell) {
+        if (region[cell] >= 0 || !isWalkable(grid.at(cell)))
+            continue;
+        const int label = static_cast<int>(regionSize.size());
+        int head = 0;
+        int tail = 0;
+        queue[tail++] = cell;
+        region[cell] = label;
+        while (head < tail) {
+            int current = queue[head++];
+            for (int step : steps) {
+                int next = current + step;  // The border keeps every step inside the map
+                if (region[next] < 0 && isWalkable(grid.at(next))) {
+                    region[next] = label;
+                    queue[tail++] = next;
+                }
+            }
+        }
+        regionSize.push_back(tail);
+    }
+    if (regionSize.size() < 2)
+        return;
+    const int largest = static_cast<int>(
+        std::max_element(regionSize.begin(), regionSize.end()) - regionSize.begin());
+
+    // 0-1 BFS: cells reached without a new wall are handled before the next wall is counted
+    ArenaVector<int> walls(cells, INT_MAX, &scratch);
+    ArenaVector<int> parent(cells, -1, &scratch);
+    ArenaVector<int> layer(&scratch);
+    ArenaVector<int> nextLayer(&scratch);
+    for (int cell = 0; cell < cells; ++cell) {
+        if (region[cell] == largest) {
+            walls[cell] = 0;
+            layer.push_back(cell);
+        }
+    }
+    for (int cost = 0; !layer.empty(); ++cost) {
+        for (size_t i = 0; i < layer.size(); ++i) {
+            int current = layer[i];
+            if (walls[current] != cost)
+                continue;  // Reached more cheaply since it was queued
+            for (int step : steps) {
+                int next = current + step;
+                Tile tile = grid.at(next);
+                if (tile != Tile::WALL && !isWalkable(tile))
+                    continue;  // Border
+                int nextCost = cost + (tile == Tile::WALL ? 1 : 0);
+                if (nextCost >= walls[next])
+                    continue;
+                walls[next] = nextCost;
+                parent[next] = current;
+                (nextCost == cost ? layer : nextLayer).push_back(next);
+            }
+        }
+        layer.swap(nextLayer);
+        nextLayer.clear();
+    }
+
+    // Each region opens the cheapest path back to the largest one
+    ArenaVector<int> entry(regionSize.size(), -1, &scratch);
+    for (int cell = 0; cell < cells; ++cell) {
+        int r = region[cell];
+        if (r >= 0 && r != largest && (entry[r] < 0 || walls[cell] < walls[entry[r]]))
+            entry[r] = cell;
+    }
+    for (int cell : entry) {
+        for (; cell >= 0 && walls[cell] > 0; cell = parent[cell]) {
+            if (grid.at(cell) == Tile::WALL)
+                grid.set(cell / size, cell % size, Tile::FLOOR);
+        }
+    }
+}
+
+// Smoothstep weight of position i inside a lattice cell of width scale
+float smoothWeight(int i, int scale) {
+    float t = static_cast<float>(i % scale) / scale;
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Value noise: random values on a lattice every `scale` cells, smoothly interpolated.
+// Every lattice row is expanded along x once, after which each map row is a plain lerp
+// between two expanded rows - a branch-free loop over floats that the compiler vectorizes.
+void addNoiseOctave(ArenaVector<float>& value, int size, int scale, float amplitude, Rng& rng,
+                    Arena& scratch) {
+    ArenaScope scope(scratch);
+    const int latticeSize = size / scale + 2;
+    ArenaVector<float> lattice(latticeSize * latticeSize, 0.0f, &scratch);
+    for (float& v : lattice) {
+        v = static_cast<float>(rng() >> 40) / static_cast<float>(1 << 24);  // [0, 1)
+    }
+
+    ArenaVector<int> column(size, 0, &scratch);
+    ArenaVector<float> weight(size, 0.0f, &scratch);
+    for (int x = 0; x < size; ++x) {
+        column[x] = x / scale;
+        weight[x] = smoothWeight(x, scale);
+    }
+
+    ArenaVector<float> expanded(latticeSize * size, 0.0f, &scratch);
+    for (int j = 0; j < latticeSize; ++j) {
+        const float* latticeRow = &lattice[j * latticeSize];
+        float* out = &expanded[j * size];
+        for (int x = 0; x < size; ++x) {
+            float a = latticeRow[column[x]];
+            float b = latticeRow[column[x] + 1];
+            out[x] = a + (b - a) * weight[x];
+        }
+    }
+
+    for (int y = 0; y < size; ++y) {
+        const float* top = &expanded[(y / scale) * size];
+        const float* bottom = top + size;
+        const float w = smoothWeight(y, scale);
+        float* out = &value[y * size];
+        for (int x = 0; x < size; ++x) {
+            out[x] += amplitude * (top[x] + (bottom[x] - top[x]) * w);
+        }
+    }
+}
+
+// Bit-sliced 4-bit counters: add one neighbour plane to (s0, s1, s2, s3) for 64 cells at once
+inline void addPlane(uint64_t plane, uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3) {
+    uint64_t c0 = s0 & plane;
+    s0 ^= plane;
+    uint64_t c1 = s1 & c0;
+    s1 ^= c0;
+    uint64_t c2 = s2 & c1;
+    s2 ^= c1;
+    s3 |= c2;
+}
+
+// One cellular-automata step over bit-packed rows (1 = wall). A cell becomes a wall when 5+ of
+// its 8 neighbours are walls, and stays one with 4+. Cells outside the map count as walls.
+void caveStep(const ArenaVector<uint64_t>& in, ArenaVector<uint64_t>& out, int size, int words,
+              const ArenaVector<uint64_t>& solidRow) {
+    for (int y = 0; y < size; ++y) {
+        const uint64_t* up = (y > 0) ? &in[(y - 1) * words] : solidRow.data();
+        const uint64_t* mid = &in[y * words];
+        const uint64_t* down = (y + 1 < size) ? &in[(y + 1) * words] : solidRow.data();
+
+        for (int k = 0; k < words; ++k) {
+            // Bit x of west() holds cell x - 1, bit x of east() holds cell x + 1
+            auto west = [&](const uint64_t* row) {
+                return (row[k] << 1) | ((k > 0) ? row[k - 1] >> 63 : 1ULL);
+            };
+            auto east = [&](const uint64_t* row) {
+                return (row[k] >> 1) | ((k + 1 < words) ? row[k + 1] << 63 : 1ULL << 63);
+            };
+
+            uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            addPlane(up[k], s0, s1, s2, s3);
+            addPlane(down[k], s0, s1, s2, s3);
+            addPlane(west(up), s0, s1, s2, s3);
+            addPlane(east(up), s0, s1, s2, s3);
+            addPlane(west(mid), s0, s1, s2, s3);
+            addPlane(east(mid), s0, s1, s2, s3);
+            addPlane(west(down), s0, s1, s2, s3);
+            addPlane(east(down), s0, s1, s2, s3);
+
+            uint64_t atLeast4 = s3 | s2;
+            uint64_t atLeast5 = s3 | (s2 & (s1 | s0));
+            out[y * words + k] = atLeast5 | (mid[k] & atLeast4);
+        }
+    }
+}
+
+// Border cells and the padding bits past the last column are always walls
+void sealBorder(ArenaVector<uint64_t>& rows, int size, int words) {
+    const int lastBit = (size - 1) % 64;
+    const uint64_t padding = (lastBit == 63) ? 0 : ~((2ULL << lastBit) - 1);
+    for (int y = 0; y < size; ++y) {
+        uint64_t* row = &rows[y * words];
+        if (y == 0 || y == size - 1) {
+            std::fill(row, row + words, ~0ULL);
+            continue;
+        }
+        row[0] |= 1ULL;
+        row[words - 1] |= padding | (1ULL << lastBit);
+    }
+}
+
+}  // namespace
+
+void ClassicTerrain::carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+                           Arena& scratch) const {
+    ArenaScope scope(scratch);
+    const int map_size = profile.mapSize;
+    TileGrid& mapGrid = level.grid;
+
+    // Borders and exit are occupied; the start cell is protected too
+    OccupancyIndex occupancy(mapGrid, &scratch);
+    occupancy.markOccupied(level.startY, level.startX);
+
+    // Every cell with a wall in its 3x3 neighbourhood: "is there a wall in this rectangle grown
+    // by one" becomes a word-parallel test of the rectangle itself
+    Bitboard nearWall(map_size, map_size, &scratch);
+
+    auto placeObstacle = [&](int r, int c) {
+        mapGrid.set(r, c, Tile::WALL);
+        occupancy.markOccupied(r, c);
+        nearWall.setRect(r - 1, c - 1, r + 1, c + 1);
+    };
+    // Obstacles keep one cell of clearance from the border and from other obstacles
+    auto isObstacleInterior = [&](int r, int c) {
+        return r > 1 && r < map_size - 2 && c > 1 && c < map_size - 2;
+    };
+    auto isValidObstacle = [&](int r, int c) {
+        return isObstacleInterior(r, c) && !nearWall.test(r, c);
+    };
+
+    // Obstacle Generation
+    // Stripes placement
+    const int minObstacleLength = profile.minStripeLength;
+    const int maxObstacleLength = profile.maxStripeLength;
+    int obstaclePlaced = 0;
+    int maxPlacementAttempts = map_size * map_size * 2;  // Limit attempts
+    int placementAttempts = 0;
+
+    while (obstaclePlaced < profile.numStripes && placementAttempts < maxPlacementAttempts) {
+        placementAttempts++;
+        bool horizontal = (randBelow(rng, 2) == 0);  // Random orientation
+        int len = minObstacleLength +
+                  randBelow(rng, maxObstacleLength - minObstacleLength + 1);  // Random length
+
+        int startY = randBelow(rng, map_size - len - 2) + 1;
+        int startX = randBelow(rng, map_size - len - 2) + 1;
+        int endY = startY + (horizontal ? 0 : len - 1);
+        int endX = startX + (horizontal ? len - 1 : 0);
+
+        // Both ends inside the obstacle area, no wall touching the stripe, all cells free
+        bool canPlace = isObstacleInterior(startY, startX) && isObstacleInterior(endY, endX) &&
+                        nearWall.rectClear(startY, startX, endY, endX) &&
+                        (horizontal ? occupancy.spanFree(startY, startX, len)
+                                    : occupancy.rectFree(startY, startX, endY, endX));
+
+        if (canPlace) {
+            for (int i = 0; i < len; ++i) {
+                placeObstacle(startY + (horizontal ? 0 : i), startX + (horizontal ? i : 0));
+            }
+
+            obstaclePlaced++;
+        }
+    }
+
+    // Blocks placement
+    const int clusterSize = profile.clusterSize;
+    int clustersPlaced = 0;
+    int maxClusterAttempts = map_size * map_size;
+    int clusterAttempts = 0;
+    ArenaVector<int> positions(clusterSize, 0, &scratch);
+
+    while (clustersPlaced < profile.numClusters && clusterAttempts < maxClusterAttempts) {
+        clusterAttempts++;
+
+        // Select a random starting position for this cluster
+        int startY = randBelow(rng, map_size - clusterSize - 2) + 1;
+        int startX = randBelow(rng, map_size - clusterSize - 2) + 1;
+        int endY = startY + clusterSize - 1;
+        int endX = startX + clusterSize - 1;
+
+        // The area must be free of anything placed or protected
+        if (!occupancy.rectFree(startY, startX, endY, endX))
+            continue;
+
+        // At least one cell must be a valid obstacle spot. When no obstacle is near the area
+        // at all, that is just "does the area reach into the obstacle interior".
+        bool validClusterArea = false;
+        if (nearWall.rectClear(startY, startX, endY, endX)) {
+            validClusterArea = endY > 1 && startY < map_size - 2 && endX > 1 && startX < map_size - 2;
+        } else {
+            for (int dy = 0; dy < clusterSize && !validClusterArea; dy++) {
+                for (int dx = 0; dx < clusterSize && !validClusterArea; dx++) {
+                    validClusterArea = isValidObstacle(startY + dy, startX + dx);
+                }
+            }
+        }
+
+        if (!validClusterArea)
+            continue;
+
+        bool placedAnyBlocks = false;
+
+        // Generate pattern
+        for (int dy = 0; dy < clusterSize; dy++) {
+            int blocksInRow = 1 + randBelow(rng, profile.maxBlocksPerRow);
+            blocksInRow = std::min(blocksInRow, clusterSize);
+
+            for (int i = 0; i < clusterSize; i++) {
+                positions[i] = i;
+            }
+            // Shuffle to randomize position selection
+            shuffleVector(positions, rng);
+
+            for (int b = 0; b < blocksInRow; b++) {
+                int y = startY + dy;
+                int x = startX + positions[b];
+
+                if (!occupancy.isOccupied(y, x)) {
+                    placeObstacle(y, x);
+                    placedAnyBlocks = true;
+                }
+            }
+        }
+
+        if (placedAnyBlocks) {
+            clustersPlaced++;
+        }
+    }
+}
+
+void NoiseTerrain::carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+                         Arena& scratch) const {
+    ArenaScope scope(scratch);
+    const int size = profile.mapSize;
+    const int scale = std::max(2, profile.noiseScale);
+
+    ArenaVector<float> value(size * size, 0.0f, &scratch);
+    addNoiseOctave(value, size, scale, 1.0f, rng, scratch);
+    addNoiseOctave(value, size, std::max(2, scale / 2), 0.5f, rng, scratch);
+
+    // Pick the threshold from the interior values so the density matches the profile
+    ArenaVector<float> interior(&scratch);
+    interior.reserve((size - 2) * (size - 2));
+    for (int y = 1; y < size - 1; ++y) {
+        interior.insert(interior.end(), value.begin() + y * size + 1,
+                        value.begin() + y * size + size - 1);
+    }
+    size_t rank = interior.size() * std::min(100, std::max(0, profile.obstacleDensity)) / 100;
+    float threshold = -1.0f;
+    if (rank > 0) {
+        std::nth_element(interior.begin(), interior.begin() + (rank - 1), interior.end());
+        threshold = interior[rank - 1];
+    }
+
+    Bitboard walls(size, size, &scratch);
+    for (int y = 0; y < size; ++y) {
+        uint64_t* row = walls.row(y);
+        const float* values = &value[y * size];
+        for (int x = 0; x < size; ++x) {
+            row[x >> 6] |= static_cast<uint64_t>(values[x] <= threshold) << (x & 63);
+        }
+    }
+    writeWalls(walls, level);
+    connectRegions(level, scratch);
+}
+
+void CaveTerrain::carve(const DifficultyProfile& profile, Rng& rng, Level& level,
+                        Arena& scratch) const {
+    ArenaScope scope(scratch);
+    const int size = profile.mapSize;
+    const int words = (size + 63) / 64;
+
+    // Random fill, one byte of engine output per cell
+    const uint64_t byteThreshold = static_cast<uint64_t>(profile.obstacleDensity) * 256 / 100;
+    ArenaVector<uint64_t> rows(size * words, 0, &scratch);
+    for (int y = 0; y < size; ++y) {
+        for (int k = 0; k < words; ++k) {
+            uint64_t bits = 0;
+            for (int chunk = 0; chunk < 8; ++chunk) {
+                uint64_t random = rng();
+                for (int b = 0; b < 8; ++b) {
+                    if (((random >> (b * 8)) & 0xFF) < byteThreshold)
+                        bits |= 1ULL << (chunk * 8 + b);
+                }
+            }
+            rows[y * words + k] = bits;
+        }
+    }
+    sealBorder(rows, size, words);
+
+    ArenaVector<uint64_t> next(rows.size(), 0, &scratch);
+    const ArenaVector<uint64_t> solidRow(words, ~0ULL, &scratch);
+    for (int i = 0; i < profile.caveIterations; ++i) {
+        caveStep(rows, next, size, words, solidRow);
+        sealBorder(next, size, words);
+        rows.swap(next);
+    }
+
+    // Same word layout as a bitboard, minus the padding walls
+    Bitboard walls(size, size, &scratch);
+    const uint64_t lastWordCells = (size % 64 == 0) ? ~0ULL : (1ULL << (size % 64)) - 1;
+    for (int y = 0; y < size; ++y) {
+        std::copy(&rows[y * words], &rows[y * words] + words, walls.row(y));
+        walls.row(y)[words - 1] &= lastWordCells;
+    }
+    writeWalls(walls, level);
+    connectRegions(level, scratch);
+}
+
+const TerrainGenerator& terrainGenerator(TerrainKind kind) {
+    static const ClassicTerrain classic;
+    static const NoiseTerrain noise;
+    static const CaveTerrain cave;
+    switch (kind) {
+        case TerrainKind::NOISE:
+            return noise;
+        case TerrainKind::CAVE:
+            return cave;
+        case TerrainKind::CLASSIC:
+        default:
+            return classic;
+    }
+}
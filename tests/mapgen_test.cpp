@@ -0,0 +1,76 @@
+// Level generation checks: every terrain at every obstacle density, for every difficulty,
+// must give complete and solvable levels
+// Usage: ./bin/mapgen_test [seeds per case]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../include/difficulty.h"
+#include "../include/mapgen.h"
+#include "../include/tilegrid.h"
+
+namespace {
+
+const TerrainKind TERRAINS[] = {TerrainKind::CLASSIC, TerrainKind::NOISE, TerrainKind::CAVE};
+const char* const TERRAIN_NAMES[] = {"classic", "noise", "cave"};
+const int DENSITIES[] = {0, 15, 30, 45, 55, 60, 75, 90};
+
+// Every package has its pickup and destination on the grid, tagged with its index
+bool placementComplete(const Level& level, int numPackages) {
+    if (static_cast<int>(level.packagePickUpLocs.size()) != numPackages ||
+        static_cast<int>(level.packageDestLocs.size()) != numPackages)
+        return false;
+    for (int i = 0; i < numPackages; ++i) {
+        const auto& pickup = level.packagePickUpLocs[i];
+        const auto& dest = level.packageDestLocs[i];
+        if (level.grid.at(pickup.first, pickup.second) != Tile::PICKUP ||
+            level.grid.idAt(pickup.first, pickup.second) != i ||
+            level.grid.at(dest.first, dest.second) != Tile::DESTINATION ||
+            level.grid.idAt(dest.first, dest.second) != i)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int seedsPerCase = 200;
+    if (argc > 1)
+        seedsPerCase = std::max(1, std::atoi(argv[1]));
+
+    int failedCases = 0;
+    for (int t = 0; t < 3; ++t) {
+        for (int density : DENSITIES) {
+            for (int d = 0; d < NUM_DIFFICULTIES; ++d) {
+                DifficultyProfile profile = DIFFICULTIES[d].profile;
+                profile.terrain = TERRAINS[t];
+                profile.obstacleDensity = density;
+
+                int unsolvable = 0;
+                int incomplete = 0;
+                for (int i = 0; i < seedsPerCase; ++i) {
+                    Level level = generatePlayableLevel(profile, roundSeed(density, i));
+                    if (!isLevelSolvable(level))
+                        unsolvable++;
+                    if (!placementComplete(level, profile.numPackages))
+                        incomplete++;
+                }
+                if (unsolvable > 0 || incomplete > 0) {
+                    std::printf("FAIL %-7s density %2d %-6s: %d unsolvable, %d incomplete of %d\n",
+                                TERRAIN_NAMES[t], density, DIFFICULTIES[d].key, unsolvable,
+                                incomplete, seedsPerCase);
+                    failedCases++;
+                }
+            }
+        }
+    }
+
+    const int cases = 3 * static_cast<int>(sizeof(DENSITIES) / sizeof(DENSITIES[0])) *
+                      NUM_DIFFICULTIES;
+    std::printf("mapgen_test: %d of %d cases passed (%d seeds each)\n", cases - failedCases,
+                cases, seedsPerCase);
+    return failedCases == 0 ? 0 : 1;
+}